@@ -0,0 +1,267 @@
+/*******************************************************************************************
+ *
+ *   Dino benchmarks
+ *   Times the hot paths of the simulation library without a window and prints one
+ *   "name ns_per_op" line per benchmark.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+#include "ghost.h"
+#include "particles.h"
+#include "render.h"
+#include "stream.h"
+#include <stdio.h>
+//----------------------------------------------------------------------------------
+
+// Local Variables Definition
+//----------------------------------------------------------------------------------
+const int BENCH_TICKS = 200000;
+const int BENCH_SNAPSHOTS = 200000;
+const int BENCH_STREAM_FRAMES = 200000;
+const int BENCH_PARTICLES = 100000;
+const int BENCH_PARTICLE_TICKS = 2000;
+const int BENCH_RENDER_FRAMES = 200000;
+const int BENCH_GHOST_TICKS = 20000;
+const int BENCH_COLLISIONS = 20000;
+
+Entity entities[MAX_ENTITIES];
+GameVariables game;
+int dinoId;
+unsigned char startSnapshot[MAX_WORLD_SNAPSHOT_SIZE];
+int startSnapshotSize;
+//----------------------------------------------------------------------------------
+
+// Local Functions Declaration
+//----------------------------------------------------------------------------------
+void ReportBenchmark(const char *name, double seconds, int operations);
+void BenchUpdateWorld();
+void BenchSnapshot();
+void BenchStreamEncode();
+void BenchParticles();
+void BenchRenderCommands();
+void BenchGhosts(int ghostCount);
+void BenchCollision();
+//----------------------------------------------------------------------------------
+
+// Main entry point
+//----------------------------------------------------------------------------------
+int main(void)
+{
+    SetTraceLogLevel(LOG_WARNING);
+    LoadSpriteTextures(true);
+    SetWorldRandomSeed(1);
+    dinoId = CreateWorld(entities, &game);
+    startSnapshotSize = SaveWorldSnapshot(entities, &game, startSnapshot, sizeof(startSnapshot));
+
+    BenchUpdateWorld();
+    BenchSnapshot();
+    BenchStreamEncode();
+    BenchParticles();
+    BenchRenderCommands();
+    BenchGhosts(1000);
+    BenchGhosts(10000);
+    BenchCollision();
+
+    UnloadSpriteTextures(true);
+    return 0;
+}
+// ----------------------------------------------------------------------------------
+
+// Benchmark Functions Definition
+// ----------------------------------------------------------------------------------
+void BenchUpdateWorld()
+{
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+    double startTime = GetWallTime();
+    for (int i = 0; i < BENCH_TICKS; i++)
+    {
+        UpdateReflexBot(entities, &game, dinoId);
+        UpdateWorld(entities, &game);
+        if (dinoComponents[dinoId].isDead)
+        {
+            RestartWorld(entities, &game, startSnapshot, startSnapshotSize, i);
+        }
+    }
+    ReportBenchmark("update_world", GetWallTime() - startTime, BENCH_TICKS);
+}
+
+void BenchSnapshot()
+{
+    static unsigned char snapshot[MAX_WORLD_SNAPSHOT_SIZE];
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+
+    double startTime = GetWallTime();
+    int size = 0;
+    for (int i = 0; i < BENCH_SNAPSHOTS; i++)
+    {
+        size = SaveWorldSnapshot(entities, &game, snapshot, sizeof(snapshot));
+    }
+    ReportBenchmark("save_world_snapshot", GetWallTime() - startTime, BENCH_SNAPSHOTS);
+
+    startTime = GetWallTime();
+    for (int i = 0; i < BENCH_SNAPSHOTS; i++)
+    {
+        LoadWorldSnapshot(entities, &game, snapshot, size);
+    }
+    ReportBenchmark("load_world_snapshot", GetWallTime() - startTime, BENCH_SNAPSHOTS);
+}
+
+void BenchStreamEncode()
+{
+    static StreamFrame frames[2];
+    static unsigned char message[STREAM_BUFFER_SIZE];
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+
+    long long bytes = 0;
+    double elapsed = 0.0;
+    for (int i = 0; i < BENCH_STREAM_FRAMES; i++)
+    {
+        UpdateReflexBot(entities, &game, dinoId);
+        UpdateWorld(entities, &game);
+        StreamFrame *frame = &frames[i % 2];
+        StreamFrame *base = &frames[(i + 1) % 2];
+        CaptureStreamFrame(entities, &game, PLAYING, 0, frame);
+        frame->tick = (unsigned int)i;
+
+        double startTime = GetWallTime();
+        bytes += EncodeStreamFrame(frame, i > 0 ? base : NULL, i > 0 ? 1 : 0, message);
+        elapsed += GetWallTime() - startTime;
+    }
+    ReportBenchmark("encode_stream_frame", elapsed, BENCH_STREAM_FRAMES);
+    printf("stream_bytes_per_tick %.1f\n", (double)bytes / BENCH_STREAM_FRAMES);
+}
+
+// Keeps BENCH_PARTICLES alive with a steady trickle dying each tick, topping the buffer back
+// up outside the timed part
+void BenchParticles()
+{
+    ClearParticles();
+    double elapsed = 0.0;
+    for (int i = 0; i < BENCH_PARTICLE_TICKS; i++)
+    {
+        int count = particles.count;
+        SpawnParticles(PARTICLE_PUFF, WIDTH / 2, HEIGHT / 2, BENCH_PARTICLES - count);
+        for (int j = count; j < particles.count; j++)
+        {
+            particles.life[j] = (float)(1 + j % BENCH_PARTICLE_TICKS);
+        }
+
+        double startTime = GetWallTime();
+        UpdateParticleSystem();
+        elapsed += GetWallTime() - startTime;
+    }
+    ReportBenchmark("update_particles_100k", elapsed, BENCH_PARTICLE_TICKS);
+}
+
+// Culling and sorting only; submitting needs a window
+void BenchRenderCommands()
+{
+    static RenderCommandList list;
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+
+    long long submitted = 0;
+    long long culled = 0;
+    double elapsed = 0.0;
+    for (int i = 0; i < BENCH_RENDER_FRAMES; i++)
+    {
+        UpdateReflexBot(entities, &game, dinoId);
+        UpdateWorld(entities, &game);
+        if (dinoComponents[dinoId].isDead)
+        {
+            RestartWorld(entities, &game, startSnapshot, startSnapshotSize, i);
+        }
+
+        double startTime = GetWallTime();
+        BuildRenderCommands(entities, &list);
+        SortRenderCommands(&list);
+        elapsed += GetWallTime() - startTime;
+        submitted += list.count;
+        culled += list.culled;
+    }
+    ReportBenchmark("build_render_commands", elapsed, BENCH_RENDER_FRAMES);
+    printf("render_submitted_per_frame %.1f\n", (double)submitted / BENCH_RENDER_FRAMES);
+    printf("render_culled_per_frame %.1f\n", (double)culled / BENCH_RENDER_FRAMES);
+}
+
+// Records one bot run and plays it back as ghostCount ghosts, timing the per-frame step.
+// Drawing them needs a window; the F3 overlay's draw time covers that in game.
+void BenchGhosts(int ghostCount)
+{
+    GhostRecorder recorder = {0};
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+    StartGhostRecording(&recorder, 1);
+    for (int i = 0; i < BENCH_GHOST_TICKS && !dinoComponents[dinoId].isDead; i++)
+    {
+        UpdateReflexBot(entities, &game, dinoId);
+        UpdateWorld(entities, &game);
+        RecordGhostSample(&recorder, dinoId);
+    }
+
+    GhostLayer ghosts = {0};
+    for (int i = 0; i < ghostCount; i++)
+    {
+        AddGhostRun(&ghosts, &recorder.run);
+    }
+    double startTime = GetWallTime();
+    for (int tick = 1; tick <= recorder.run.tickCount; tick++)
+    {
+        UpdateGhostLayer(&ghosts, tick);
+    }
+    ReportBenchmark(TextFormat("update_ghosts_%ik", ghostCount / 1000), GetWallTime() - startTime, recorder.run.tickCount);
+    if (ghostCount == 1000)
+    {
+        printf("ghost_bytes_per_tick %.2f\n", (double)recorder.run.size / recorder.run.tickCount);
+    }
+
+    UnloadGhostLayer(&ghosts);
+    UnloadGhostRecording(&recorder);
+}
+
+// The narrow phase alone, for the first obstacle swept across the dino so that about half
+// the tests hit
+void BenchCollision()
+{
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+    int obstacleId = 0;
+    while (obstacleId < nextEntityId && !HasComponent(entities, obstacleId, OBSTACLE))
+    {
+        obstacleId++;
+    }
+    PositionComponent dinoPosition = positionComponents[dinoId];
+    int sweep = (int)(spriteComponents[dinoId].sourceRec.width + spriteComponents[obstacleId].sourceRec.width);
+
+    int hits = 0;
+    double startTime = GetWallTime();
+    for (int i = 0; i < BENCH_COLLISIONS; i++)
+    {
+        positionComponents[obstacleId] = (PositionComponent){dinoPosition.x + ScalarFromInt(i % sweep - sweep / 2), dinoPosition.y};
+        hits += IsCollisionMaskOverlap(obstacleId, dinoId);
+    }
+    ReportBenchmark("collide_pixels", GetWallTime() - startTime, BENCH_COLLISIONS);
+
+    startTime = GetWallTime();
+    for (int i = 0; i < BENCH_COLLISIONS; i++)
+    {
+        positionComponents[obstacleId] = (PositionComponent){dinoPosition.x + ScalarFromInt(i % sweep - sweep / 2), dinoPosition.y};
+        hits += IsHitboxOverlap(obstacleId, dinoId);
+    }
+    ReportBenchmark("collide_boxes", GetWallTime() - startTime, BENCH_COLLISIONS);
+    printf("collide_hit_fraction %.2f\n", hits / (2.0 * BENCH_COLLISIONS));
+}
+// ----------------------------------------------------------------------------------
+
+// Helper Functions Definition
+// ----------------------------------------------------------------------------------
+void ReportBenchmark(const char *name, double seconds, int operations)
+{
+    printf("%s %.1f\n", name, seconds * 1e9 / operations);
+}
+// ----------------------------------------------------------------------------------
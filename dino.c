@@ -0,0 +1,1359 @@
+/*******************************************************************************************
+ *
+ *   Dino simulation library
+ *   See dino.h.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+//----------------------------------------------------------------------------------
+
+// Local Variables Definition
+//----------------------------------------------------------------------------------
+const int MAX_FRAME_SPEED = 99;
+const int MIN_FRAME_SPEED = 60;
+const int FPS = 60;
+const int MAX_CLOUDS = 6;
+const int MAX_OBSTACLE_LENGTH = 3;
+const int MAX_OBSTACLE_DUPLICATION = 2;
+const int MAX_SPEED = 13;
+const int SPEED = 6;
+const int HEIGHT = 600;
+const int WIDTH = 1280;
+const int TREX_SPRITES_WIDTH = 88;
+const int TREX_SPRITES_HEIGHT = 94;
+const int TREX_SPRITES_WIDTH_DUCK = 236 / 2;
+const int TREX_SPRITES_HEIGHT_DUCK = 60;
+const int CACTUS_LARGE_SPRITE_X = 652;
+const int CACTUS_LARGE_SPRITE_Y = 2;
+const int CACTUS_LARGE_SPRITE_WIDTH = 25;
+const int CACTUS_LARGE_SPRITE_HEIGHT = 70;
+const int CACTUS_SMALL_SPRITE_X = 446;
+const int CACTUS_SMALL_SPRITE_Y = 2;
+const int CACTUS_SMALL_SPRITE_WIDTH = 17;
+const int CACTUS_SMALL_SPRITE_HEIGHT = 35;
+const int CLOUD_SPRITE_X = 166;
+const int CLOUD_SPRITE_Y = 2;
+const int CLOUD_SPRITE_WIDTH = 46;
+const int CLOUD_SPRITE_HEIGHT = 27;
+const int HORIZON_SPRITE_X = 2;
+const int HORIZON_SPRITE_Y = 104;
+const int HORIZON_SPRITE_WIDTH = 600;
+const int PTERODACTYL_SPRITE_X = 260;
+const int PTERODACTYL_SPRITE_Y = 2;
+const int PTERODACTYL_SPRITE_WIDTH = 46;
+const int PTERODACTYL_SPRITE_HEIGHT = 40;
+const float FLOOR_Y_POS = 0.8f * HEIGHT;
+const float JUMP_Y_POS = 100.0f;
+const float INITIAL_JUMP_VELOCITY = -24.0f;
+const float DROP_VELOCITY = 12.0f;
+const float DINO_START_X_POS = 250.0f;
+const float DINO_PLAY_X_POS = WIDTH / 2 + TREX_SPRITES_WIDTH;
+const int MAX_OBSTACLES = 2;
+
+// non const/macro variables
+int nextEntityId = 0;
+unsigned int worldRandomState = 1;
+
+PositionComponent positionComponents[MAX_ENTITIES];
+VelocityComponent velocityComponents[MAX_ENTITIES];
+SpriteComponent spriteComponents[MAX_ENTITIES];
+AnimationComponent animationComponents[MAX_ENTITIES];
+DinoComponent dinoComponents[MAX_ENTITIES];
+CollisionComponent collisionComponents[MAX_ENTITIES];
+ObstacleComponent obstacleComponents[MAX_ENTITIES];
+CloudComponent cloudComponents[MAX_ENTITIES];
+InputComponent inputComponents[MAX_ENTITIES];
+
+InputQueue inputQueue;
+InputLatencyStats inputLatencyStats;
+SimEventQueue simEventQueue;
+RewindRing rewindRing;
+Texture2D spriteTextures[SPRITE_TEXTURE_COUNT];
+Image spriteImages[SPRITE_TEXTURE_COUNT];
+HitboxTable hitboxTable;
+CollisionMode collisionMode = COLLISION_PIXELS;
+CollisionStats collisionStats;
+//----------------------------------------------------------------------------------
+
+// World Functions Definition
+// ----------------------------------------------------------------------------------
+void LoadSpriteTextures(bool isHeadless)
+{
+    const char *fileNames[SPRITE_TEXTURE_COUNT] = {
+        "resources/dino.png",
+        "resources/dino_duck.png",
+        "resources/pterodactyl.png",
+        "resources/cactus_large.png",
+        "resources/cactus_small.png",
+        "resources/cloud.png",
+        "resources/horizon.png"};
+    for (int i = 0; i < SPRITE_TEXTURE_COUNT; i++)
+    {
+        spriteImages[i] = LoadImage(fileNames[i]);
+        // Headless runs never draw, so a placeholder with a unique id and the real size will do
+        spriteTextures[i] = isHeadless ? (Texture2D){(unsigned int)i + 1, spriteImages[i].width, spriteImages[i].height, 1, spriteImages[i].format}
+                                       : LoadTextureFromImage(spriteImages[i]);
+    }
+    BuildHitboxTable();
+}
+
+void UnloadSpriteTextures(bool isHeadless)
+{
+    for (int i = 0; i < SPRITE_TEXTURE_COUNT; i++)
+    {
+        UnloadImage(spriteImages[i]);
+        if (!isHeadless)
+        {
+            UnloadTexture(spriteTextures[i]);
+        }
+    }
+}
+
+int CreateWorld(Entity *entities, GameVariables *game)
+{
+    Texture2D dinoTexture = spriteTextures[TEXTURE_DINO];
+    Texture2D cloudTexture = spriteTextures[TEXTURE_CLOUD];
+
+    nextEntityId = 0;
+    *game = (GameVariables){0, 0, ToScalar(1.75f), 0};
+    // Snapshots copy the arrays byte for byte, padding included, so every byte starts at zero
+    memset(positionComponents, 0, sizeof(positionComponents));
+    memset(velocityComponents, 0, sizeof(velocityComponents));
+    memset(spriteComponents, 0, sizeof(spriteComponents));
+    memset(animationComponents, 0, sizeof(animationComponents));
+    memset(dinoComponents, 0, sizeof(dinoComponents));
+    memset(collisionComponents, 0, sizeof(collisionComponents));
+    memset(obstacleComponents, 0, sizeof(obstacleComponents));
+    memset(cloudComponents, 0, sizeof(cloudComponents));
+    memset(inputComponents, 0, sizeof(inputComponents));
+
+    int dinoId = nextEntityId;
+    entities[dinoId] = CreateEntity();
+    AddComponent(entities, dinoId, POSITION);
+    AddComponent(entities, dinoId, VELOCITY);
+    AddComponent(entities, dinoId, SPRITE);
+    AddComponent(entities, dinoId, ANIMATION);
+    AddComponent(entities, dinoId, DINO);
+    AddComponent(entities, dinoId, COLLISION);
+    AddComponent(entities, dinoId, INPUT);
+    positionComponents[dinoId] = (PositionComponent){ToScalar(DINO_START_X_POS), ToScalar(FLOOR_Y_POS)};
+    velocityComponents[dinoId] = (VelocityComponent){0, 0};
+    spriteComponents[dinoId] = (SpriteComponent){dinoTexture, {0.0f, 0.0f, (float)dinoTexture.width / 6, (float)dinoTexture.height}};
+    animationComponents[dinoId] = (AnimationComponent){0, {2, 3}, 8, 0};
+    // DinoComponent has padding, which a compound literal leaves unspecified
+    dinoComponents[dinoId].isDucking = false;
+    dinoComponents[dinoId].isJumping = false;
+    dinoComponents[dinoId].isDead = false;
+    dinoComponents[dinoId].jumpFrameCount = 0;
+    dinoComponents[dinoId].slideFrameCount = 0;
+    collisionComponents[dinoId] = (CollisionComponent){(Rectangle){ScalarToFloat(positionComponents[dinoId].x), ScalarToFloat(positionComponents[dinoId].y), (float)dinoTexture.width / 6, (float)dinoTexture.height}};
+    inputComponents[dinoId] = (InputComponent){false, false};
+
+    for (int i = 0; i < MAX_OBSTACLES * 2; i++)
+    {
+        int obstacleId = nextEntityId;
+        entities[obstacleId] = CreateEntity();
+        AddComponent(entities, obstacleId, POSITION);
+        AddComponent(entities, obstacleId, VELOCITY);
+        AddComponent(entities, obstacleId, SPRITE);
+        AddComponent(entities, obstacleId, OBSTACLE);
+        AddComponent(entities, obstacleId, COLLISION);
+        obstacleComponents[obstacleId].xIndex = i;
+        positionComponents[obstacleId].x = ScalarFromInt(-1000);
+        UpdateObstacleTypeSystem(entities);
+        UpdateObstacleTextureSystem(entities, spriteTextures[TEXTURE_CACTUS_LARGE], spriteTextures[TEXTURE_CACTUS_SMALL], spriteTextures[TEXTURE_PTERODACTYL]);
+        UpdateObstacleVelocity(obstacleId, ScalarFromInt(1));
+        UpdateObstaclePosition(obstacleId, game->scrollIndex);
+    }
+
+    for (int i = 0; i < MAX_CLOUDS; i++)
+    {
+        int cloudId = nextEntityId;
+        entities[cloudId] = CreateEntity();
+        AddComponent(entities, cloudId, POSITION);
+        AddComponent(entities, cloudId, VELOCITY);
+        AddComponent(entities, cloudId, SPRITE);
+        AddComponent(entities, cloudId, CLOUD);
+        velocityComponents[cloudId].x = ScalarFromInt(-1);
+        velocityComponents[cloudId].y = 0;
+        spriteComponents[cloudId].texture = cloudTexture;
+        spriteComponents[cloudId].sourceRec = (Rectangle){0, 0, (float)cloudTexture.width, (float)cloudTexture.height};
+        cloudComponents[cloudId].xIndex = i;
+        cloudComponents[cloudId].yIndex = i;
+        positionComponents[cloudId].x = ScalarFromInt(i * (cloudTexture.width + 20) + GetWorldRandomValue(0, MAX_CLOUDS / 2) * WIDTH);
+        positionComponents[cloudId].y = ScalarFromInt(30 + i * (cloudTexture.height + 20));
+    }
+    ClearSimEvents();
+
+    return dinoId;
+}
+
+void UpdateWorld(Entity *entities, GameVariables *game)
+{
+    // Update Systems
+    //----------------------------------------------------------------------------------
+    simEventQueue.tick = game->frameCounter;
+    ApplyInputEventsSystem(entities, game->frameCounter);
+    UpdatePositionSystem(entities, game->scrollIndex);
+    UpdateDinoPoseSystem(entities);
+    UpdateDinoAnimationSystem(entities, spriteTextures[TEXTURE_DINO], spriteTextures[TEXTURE_DINO_DUCK]);
+    UpdateVelocitySystem(entities, game->scrollMultiplier);
+    UpdateObstacleTypeSystem(entities);
+    UpdateFrameCounterSystem(entities);
+    UpdateCurrentFrameIndexSystem(entities);
+    UpdateObstacleTextureSystem(entities, spriteTextures[TEXTURE_CACTUS_LARGE], spriteTextures[TEXTURE_CACTUS_SMALL], spriteTextures[TEXTURE_PTERODACTYL]);
+    UpdateCollisionSystem(entities);
+    //----------------------------------------------------------------------------------
+
+    // Update game variables
+    //----------------------------------------------------------------------------------
+    game->frameCounter++;
+    game->scrollIndex -= ScalarMul(ToScalar(2.5f), game->scrollMultiplier);
+#ifdef DINO_FIXED_POINT
+    // x1.00015 as a Q32 factor, so the compounding keeps 32 fractional bits
+    game->scrollMultiplier = (Scalar)(((int64_t)game->scrollMultiplier * 4295611541LL) >> 32);
+    if (game->score % 100 == 0 && game->score != 0)
+    {
+        game->scrollMultiplier += (Scalar)((int64_t)game->score * SCALAR_ONE / 20000);
+    }
+#else
+    game->scrollMultiplier *= 1.00015f;
+    if (game->score % 100 == 0 && game->score != 0)
+    {
+        game->scrollMultiplier += 0.005f * game->score / 100;
+    }
+#endif
+
+    if (game->scrollIndex <= ScalarFromInt(-spriteTextures[TEXTURE_HORIZON].width))
+    {
+        game->scrollIndex = 0;
+    }
+    if (game->frameCounter % 10 == 0)
+    {
+        game->score += fmax(1 * ScalarToFloat(game->scrollMultiplier), 1.0f);
+    }
+    //----------------------------------------------------------------------------------
+}
+
+void RestartWorld(Entity *entities, GameVariables *game, const unsigned char *startSnapshot, int startSnapshotSize, unsigned int seed)
+{
+    Texture2D cloudTexture = spriteTextures[TEXTURE_CLOUD];
+
+    LoadWorldSnapshot(entities, game, startSnapshot, startSnapshotSize);
+    SetWorldRandomSeed(seed);
+    ClearInputEvents(entities);
+    ClearRewindSnapshots();
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (HasComponent(entities, i, OBSTACLE))
+        {
+            positionComponents[i].x = ScalarFromInt(-1000);
+            UpdateObstacleTypeSystem(entities);
+            UpdateObstacleTextureSystem(entities, spriteTextures[TEXTURE_CACTUS_LARGE], spriteTextures[TEXTURE_CACTUS_SMALL], spriteTextures[TEXTURE_PTERODACTYL]);
+            UpdateObstacleVelocity(i, ScalarFromInt(1));
+            UpdateObstaclePosition(i, game->scrollIndex);
+        }
+        if (HasComponent(entities, i, CLOUD))
+        {
+            positionComponents[i].x = ScalarFromInt(cloudComponents[i].xIndex * (cloudTexture.width + 20) + GetWorldRandomValue(0, MAX_CLOUDS / 2) * WIDTH);
+            positionComponents[i].y = ScalarFromInt(30 + cloudComponents[i].yIndex * (cloudTexture.height + 20));
+        }
+    }
+    // Laying out the course is not part of the run
+    ClearSimEvents();
+}
+// ----------------------------------------------------------------------------------
+
+// Animation + Frames Functions Definition
+// ----------------------------------------------------------------------------------
+void UpdateDinoAnimationSystem(Entity *entities, Texture2D dinoTexture, Texture2D dinoDuckTexture)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, DINO))
+            continue;
+        if (!HasComponent(entities, i, ANIMATION))
+            continue;
+        if (!HasComponent(entities, i, SPRITE))
+            continue;
+        if (dinoComponents[i].isDead)
+        {
+            spriteComponents[i].texture = dinoTexture;
+            spriteComponents[i].sourceRec.width = (float)TREX_SPRITES_WIDTH;
+            spriteComponents[i].sourceRec.height = (float)TREX_SPRITES_HEIGHT;
+            animationComponents[i].frameIndexSlice[0] = 4;
+            animationComponents[i].frameIndexSlice[1] = 4;
+        }
+        else if (positionComponents[i].y < ToScalar(FLOOR_Y_POS))
+        {
+            spriteComponents[i].texture = dinoTexture;
+            spriteComponents[i].sourceRec.width = (float)TREX_SPRITES_WIDTH;
+            spriteComponents[i].sourceRec.height = (float)TREX_SPRITES_HEIGHT;
+            animationComponents[i].frameIndexSlice[0] = 0;
+            animationComponents[i].frameIndexSlice[1] = 0;
+        }
+        else if (dinoComponents[i].isDucking)
+        {
+            spriteComponents[i].texture = dinoDuckTexture;
+            spriteComponents[i].sourceRec.width = (float)TREX_SPRITES_WIDTH_DUCK;
+            spriteComponents[i].sourceRec.height = (float)TREX_SPRITES_HEIGHT_DUCK;
+            animationComponents[i].frameIndexSlice[0] = 0;
+            animationComponents[i].frameIndexSlice[1] = 1;
+        }
+        else
+        {
+            spriteComponents[i].texture = dinoTexture;
+            spriteComponents[i].sourceRec.width = (float)TREX_SPRITES_WIDTH;
+            spriteComponents[i].sourceRec.height = (float)TREX_SPRITES_HEIGHT;
+            animationComponents[i].frameIndexSlice[0] = 2;
+            animationComponents[i].frameIndexSlice[1] = 3;
+        }
+    }
+}
+
+void UpdateDinoPoseSystem(Entity *entities)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, DINO))
+            continue;
+        if (!HasComponent(entities, i, POSITION))
+            continue;
+        bool wasJumping = dinoComponents[i].isJumping;
+        bool wasDucking = dinoComponents[i].isDucking;
+        dinoComponents[i].isJumping = IsJumping(i);
+        dinoComponents[i].isDucking = IsDucking(i);
+        inputComponents[i].jumpPressed = false;
+
+        if (!wasJumping && dinoComponents[i].isJumping)
+        {
+            PushSimEvent(SIM_EVENT_JUMP, i, -1, 0);
+        }
+        if (wasJumping && !dinoComponents[i].isJumping)
+        {
+            PushSimEvent(SIM_EVENT_LAND, i, -1, 0);
+        }
+        if (!wasDucking && dinoComponents[i].isDucking)
+        {
+            PushSimEvent(SIM_EVENT_DUCK, i, -1, 0);
+        }
+        if (wasDucking && !dinoComponents[i].isDucking)
+        {
+            PushSimEvent(SIM_EVENT_STAND, i, -1, 0);
+        }
+    }
+}
+
+void UpdatePositionSystem(Entity *entities, Scalar scrollIndex)
+{
+    // Integrate in one branch-free pass so it vectorises, then apply the per-kind rules, which
+    // only ever touch their own entity
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        Scalar isMoving = (entities[i].componentMask & (POSITION | VELOCITY)) == (POSITION | VELOCITY);
+        positionComponents[i].x += isMoving * velocityComponents[i].x;
+        positionComponents[i].y += isMoving * velocityComponents[i].y;
+    }
+
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, POSITION))
+            continue;
+        if (!HasComponent(entities, i, VELOCITY))
+            continue;
+
+        if (HasComponent(entities, i, DINO))
+        {
+            UpdateDinoPosition(i);
+        }
+
+        if (HasComponent(entities, i, CLOUD))
+        {
+            UpdateCloudPosition(i, scrollIndex);
+        }
+
+        if (HasComponent(entities, i, OBSTACLE))
+        {
+            UpdateObstaclePosition(i, scrollIndex);
+        }
+    }
+}
+
+void UpdateVelocitySystem(Entity *entities, Scalar scrollMultiplier)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, VELOCITY))
+            continue;
+        if (!HasComponent(entities, i, POSITION))
+            continue;
+        if (HasComponent(entities, i, DINO))
+        {
+            UpdateDinoVelocity(i, scrollMultiplier);
+        }
+        if (HasComponent(entities, i, OBSTACLE))
+        {
+            UpdateObstacleVelocity(i, scrollMultiplier);
+        }
+        if (HasComponent(entities, i, CLOUD))
+        {
+            UpdateCloudVelocity(i, scrollMultiplier);
+        }
+    }
+}
+
+void UpdateDinoVelocity(int i, Scalar scrollMultiplier)
+{
+    if (!dinoComponents[i].isJumping)
+    {
+        velocityComponents[i].y = 0;
+        dinoComponents[i].jumpFrameCount = 0;
+    }
+    else
+    {
+#ifdef DINO_FIXED_POINT
+        // A * sin(2 * PI * f * t + PI / 2) with the phase kept in turns
+        Scalar multiplier = scrollMultiplier / 4;
+        Scalar A = ScalarMul(ToScalar(INITIAL_JUMP_VELOCITY - DROP_VELOCITY), multiplier);
+        Scalar turns = (Scalar)((int64_t)multiplier * dinoComponents[i].jumpFrameCount / MIN_FRAME_SPEED);
+        velocityComponents[i].y = ScalarMul(A, ScalarSinTurns(turns + SCALAR_ONE / 4));
+#else
+        float multiplier = 0.25f * scrollMultiplier;
+        float A = (float)(INITIAL_JUMP_VELOCITY - DROP_VELOCITY) * multiplier;
+        float f = multiplier / (float)MIN_FRAME_SPEED;
+        float phi = PI / 2;
+        float t = dinoComponents[i].jumpFrameCount;
+        velocityComponents[i].y =
+            A *
+            sin(2 * PI * f * t + phi);
+#endif
+        dinoComponents[i].jumpFrameCount++;
+    }
+
+    if (positionComponents[i].x < ToScalar(DINO_PLAY_X_POS) &&
+        (positionComponents[i].y == ToScalar(FLOOR_Y_POS) || dinoComponents[i].isDucking))
+    {
+#ifdef DINO_FIXED_POINT
+        Scalar offset = positionComponents[i].x - ToScalar((DINO_START_X_POS + DINO_PLAY_X_POS) / 2);
+        velocityComponents[i].x = -ScalarSinTurns(ScalarDiv(offset, ToScalar(DINO_PLAY_X_POS - DINO_START_X_POS)) / 2);
+#else
+        velocityComponents[i].x =
+            -sin(PI *
+                 ((positionComponents[i].x -
+                   (DINO_START_X_POS + DINO_PLAY_X_POS) / 2) /
+                  (DINO_PLAY_X_POS - DINO_START_X_POS)));
+#endif
+    }
+    else
+    {
+        velocityComponents[i].x = 0;
+        dinoComponents[i].slideFrameCount = 0;
+    }
+}
+
+void UpdateFrameCounterSystem(Entity *entities)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if ((entities[i].componentMask & ANIMATION) != ANIMATION)
+            continue;
+        animationComponents[i].framesCounter++;
+        if (animationComponents[i].framesCounter >= (60 / animationComponents[i].framesSpeed))
+        {
+            animationComponents[i].framesCounter = 0;
+        }
+    }
+}
+
+void UpdateCurrentFrameIndexSystem(Entity *entities)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if ((entities[i].componentMask & ANIMATION) != ANIMATION)
+            continue;
+        if ((entities[i].componentMask & SPRITE) != SPRITE)
+            continue;
+        if (animationComponents[i].framesCounter == 0)
+        {
+            animationComponents[i].currentFrameIndex++;
+            if (animationComponents[i].currentFrameIndex > animationComponents[i].frameIndexSlice[1] - animationComponents[i].frameIndexSlice[0])
+                animationComponents[i].currentFrameIndex = 0;
+        }
+        spriteComponents[i].sourceRec.x = (float)spriteComponents[i].sourceRec.width * (float)(animationComponents[i].currentFrameIndex + animationComponents[i].frameIndexSlice[0]);
+    }
+}
+
+void UpdateCloudVelocity(int i, Scalar scrollMultiplier)
+{
+    velocityComponents[i].x = -ScalarMul(ToScalar(1.5f), scrollMultiplier);
+}
+
+void UpdateObstacleVelocity(int i, Scalar scrollMultiplier)
+{
+    velocityComponents[i].x = -ScalarMul(ToScalar(2.5f), scrollMultiplier);
+}
+
+void UpdateCloudPosition(int i, Scalar scrollIndex)
+{
+    if (positionComponents[i].x < ToScalar(-spriteComponents[i].sourceRec.width))
+    {
+        positionComponents[i].x = ToScalar(cloudComponents[i].xIndex * (spriteComponents[i].sourceRec.width + 20) + GetWorldRandomValue(0, MAX_CLOUDS / 2) * WIDTH) + scrollIndex;
+        positionComponents[i].y = ToScalar(30 + cloudComponents[i].yIndex * (spriteComponents[i].sourceRec.height + 20));
+    }
+}
+
+void UpdateDinoPosition(int i)
+{
+    if (positionComponents[i].y > ToScalar(FLOOR_Y_POS))
+    {
+        positionComponents[i].y = ToScalar(FLOOR_Y_POS);
+    }
+    if (IsDucking(i))
+    {
+        positionComponents[i].y = ToScalar(FLOOR_Y_POS + (TREX_SPRITES_HEIGHT - TREX_SPRITES_HEIGHT_DUCK));
+    }
+    if (dinoComponents[i].isDead)
+    {
+        positionComponents[i].y = ToScalar(FLOOR_Y_POS);
+    }
+    if (positionComponents[i].x > ScalarFromInt(WIDTH / 2))
+    {
+        positionComponents[i].x = ScalarFromInt(WIDTH / 2);
+    }
+}
+
+void UpdateObstaclePosition(int i, Scalar scrollIndex)
+{
+    if (IsOutOfBounds(i))
+    {
+        positionComponents[i].x = ScalarFromInt(WIDTH +
+                                                i * WIDTH / MAX_OBSTACLES) +
+                                  scrollIndex;
+        // Late in a horizon scroll the new spot can be left of the screen already. The
+        // obstacle is placed again once it drifts out of bounds, and only a placement that
+        // can be seen counts as a spawn.
+        if (positionComponents[i].x > ToScalar(-spriteComponents[i].sourceRec.width))
+        {
+            PushSimEvent(SIM_EVENT_SPAWN, i, obstacleComponents[i].type, GetObstacleClusterSize(i));
+        }
+    }
+
+    switch (obstacleComponents[i].type)
+    {
+    case CACTUS_LARGE:
+        positionComponents[i].y = ToScalar(FLOOR_Y_POS - 15);
+        break;
+    case CACTUS_SMALL:
+        positionComponents[i].y = ToScalar(FLOOR_Y_POS + 10);
+        break;
+    case PTERODACTYL:
+        positionComponents[i].y = ToScalar(FLOOR_Y_POS - 60);
+        break;
+    }
+}
+
+void UpdateObstacleTypeSystem(Entity *entities)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, OBSTACLE))
+            continue;
+        if (!IsOutOfBounds(i))
+            continue;
+        obstacleComponents[i].type = GetWorldRandomValue(0, 2);
+    }
+}
+
+void UpdateObstacleTextureSystem(Entity *entities, Texture2D cactusLargeTexture, Texture2D cactusSmallTexture, Texture2D pterodactylTexture)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, OBSTACLE))
+            continue;
+        if (!HasComponent(entities, i, SPRITE))
+            continue;
+        if (!IsOutOfBounds(i))
+            continue;
+        switch (obstacleComponents[i].type)
+        {
+        case CACTUS_LARGE:
+            RemoveComponent(entities, i, ANIMATION);
+            spriteComponents[i].texture = cactusLargeTexture;
+            int spriteOffsetLargeCactus = GetWorldRandomValue(0, 3);
+            int clusterSizeLargeCactus = GetWorldRandomValue(1, 2);
+            spriteComponents[i].sourceRec = (Rectangle){cactusLargeTexture.width / 6.0f * (float)spriteOffsetLargeCactus, 0, (float)cactusLargeTexture.width / 6.0f * (float)clusterSizeLargeCactus, (float)cactusLargeTexture.height};
+            break;
+        case CACTUS_SMALL:
+            RemoveComponent(entities, i, ANIMATION);
+            spriteComponents[i].texture = cactusSmallTexture;
+            int spriteOffsetSmallCactus = GetWorldRandomValue(0, 6);
+            int clusterSizeSmallCactus = GetWorldRandomValue(1, 2);
+            spriteComponents[i].sourceRec = (Rectangle){cactusSmallTexture.width / 6.0f * (float)spriteOffsetSmallCactus, 0, (float)cactusSmallTexture.width / 6.0f * (float)clusterSizeSmallCactus, (float)cactusSmallTexture.height};
+            break;
+        case PTERODACTYL:
+            AddComponent(entities, i, ANIMATION);
+            animationComponents[i] = (AnimationComponent){0, {0, 1}, 3, 0};
+            spriteComponents[i].texture = pterodactylTexture;
+            spriteComponents[i].sourceRec = (Rectangle){0, 0, (float)pterodactylTexture.width / 2, (float)pterodactylTexture.height};
+            break;
+        }
+    }
+}
+
+void UpdateCollisionSystem(Entity *entities)
+{
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, COLLISION))
+            continue;
+        if (!HasComponent(entities, i, POSITION))
+            continue;
+        if (!HasComponent(entities, i, OBSTACLE))
+            continue;
+        for (int j = 0; j < nextEntityId; j++)
+        {
+            if (!HasComponent(entities, j, DINO))
+                continue;
+            if (!IsSpriteOverlap(
+                    (Rectangle){ScalarToFloat(positionComponents[i].x),
+                                ScalarToFloat(positionComponents[i].y),
+                                spriteComponents[i].sourceRec.width,
+                                spriteComponents[i].sourceRec.height},
+                    (Rectangle){ScalarToFloat(positionComponents[j].x),
+                                ScalarToFloat(positionComponents[j].y),
+                                spriteComponents[j].sourceRec.width,
+                                spriteComponents[j].sourceRec.height}))
+                continue;
+            if (!IsCollisionOverlap(i, j))
+                continue;
+            if (!dinoComponents[j].isDead)
+            {
+                PushSimEvent(SIM_EVENT_HIT, j, i, obstacleComponents[i].type);
+            }
+            dinoComponents[j].isDead = true;
+            break;
+        }
+    }
+}
+
+bool IsCollisionMaskOverlap(int i, int j)
+{
+    CollisionMask mask1 = GetCollisionMaskFromSprite(i);
+    CollisionMask mask2 = GetCollisionMaskFromSprite(j);
+
+    int xStart = ScalarToInt(positionComponents[i].x) - ScalarToInt(positionComponents[j].x);
+    int yStart = ScalarToInt(positionComponents[i].y) - ScalarToInt(positionComponents[j].y);
+    int xEnd = xStart + mask1.width;
+    int yEnd = yStart + mask1.height;
+
+    for (int x = xStart; x < xEnd; x++)
+    {
+        for (int y = yStart; y < yEnd; y++)
+        {
+            if (x < 0 || x >= mask2.width || y < 0 || y >= mask2.height)
+                continue;
+            if (mask1.pixels[(x - xStart) + (y - yStart) * mask1.width] == 1 && mask2.pixels[x + y * mask2.width] == 1)
+            {
+                free(mask1.pixels);
+                free(mask2.pixels);
+                return true;
+            }
+        }
+    }
+
+    free(mask1.pixels);
+    free(mask2.pixels);
+    return false;
+}
+
+CollisionMask GetCollisionMaskFromSprite(int i)
+{
+    // Prefer the CPU copy of the sheet; reading a texture back needs a GPU context.
+    int texture = GetSpriteTextureIndex(spriteComponents[i].texture);
+    if (texture >= 0)
+        return GetCollisionMaskFromImage(spriteImages[texture], spriteComponents[i].sourceRec);
+
+    Image image = LoadImageFromTexture(spriteComponents[i].texture);
+    CollisionMask collisionMask = GetCollisionMaskFromImage(image, spriteComponents[i].sourceRec);
+    UnloadImage(image);
+    return collisionMask;
+}
+
+CollisionMask GetCollisionMaskFromImage(Image sheet, Rectangle sourceRec)
+{
+    Image image = ImageCopy(sheet);
+    ImageCrop(&image, sourceRec);
+    CollisionMask collisionMask = (CollisionMask){image.width, image.height, malloc(image.width * image.height)};
+    for (int x = 0; x < image.width; x++)
+    {
+        for (int y = 0; y < image.height; y++)
+        {
+            Color pixelColor = GetImageColor(image, x, y);
+            if (pixelColor.a == 0)
+            {
+                collisionMask.pixels[x + y * image.width] = 0;
+                continue;
+            }
+            collisionMask.pixels[x + y * image.width] = 1;
+        }
+    }
+    UnloadImage(image);
+    return collisionMask;
+}
+
+// ----------------------------------------------------------------------------------
+
+// Hitbox Functions Definition
+// ----------------------------------------------------------------------------------
+bool IsCollisionOverlap(int i, int j)
+{
+    switch (collisionMode)
+    {
+    case COLLISION_BOXES:
+        return IsHitboxOverlap(i, j);
+    case COLLISION_COMPARE:
+    {
+        bool isPixelHit = IsCollisionMaskOverlap(i, j);
+        bool isBoxHit = IsHitboxOverlap(i, j);
+        collisionStats.tests++;
+        collisionStats.pixelHits += isPixelHit;
+        collisionStats.boxHits += isBoxHit;
+        collisionStats.disagreements += isPixelHit != isBoxHit;
+        return isPixelHit;
+    }
+    default:
+        return IsCollisionMaskOverlap(i, j);
+    }
+}
+
+// Falls back to the masks for a sprite whose frame has no table
+bool IsHitboxOverlap(int i, int j)
+{
+    int texture1 = GetSpriteTextureIndex(spriteComponents[i].texture);
+    int texture2 = GetSpriteTextureIndex(spriteComponents[j].texture);
+    const HitboxFrame *frame1 = texture1 >= 0 ? GetHitboxFrame(texture1, spriteComponents[i].sourceRec) : NULL;
+    const HitboxFrame *frame2 = texture2 >= 0 ? GetHitboxFrame(texture2, spriteComponents[j].sourceRec) : NULL;
+    if (frame1 == NULL || frame2 == NULL)
+        return IsCollisionMaskOverlap(i, j);
+
+    // Same pixel grid as the masks: frame1 offset into frame2's space
+    int xOffset = ScalarToInt(positionComponents[i].x) - ScalarToInt(positionComponents[j].x);
+    int yOffset = ScalarToInt(positionComponents[i].y) - ScalarToInt(positionComponents[j].y);
+    for (int a = 0; a < frame1->count; a++)
+    {
+        Hitbox box1 = frame1->boxes[a];
+        int x1 = box1.x + xOffset;
+        int y1 = box1.y + yOffset;
+        for (int b = 0; b < frame2->count; b++)
+        {
+            Hitbox box2 = frame2->boxes[b];
+            if (x1 < box2.x + box2.width && box2.x < x1 + box1.width &&
+                y1 < box2.y + box2.height && box2.y < y1 + box1.height)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Builds the tables for every frame the animation and obstacle systems can cut from the
+// sheets, so none are made mid-run. Call once the sprite images are loaded.
+void BuildHitboxTable()
+{
+    hitboxTable.count = 0;
+    for (int frame = 0; frame < spriteImages[TEXTURE_DINO].width / TREX_SPRITES_WIDTH; frame++)
+    {
+        GetHitboxFrame(TEXTURE_DINO, (Rectangle){(float)TREX_SPRITES_WIDTH * (float)frame, 0, (float)TREX_SPRITES_WIDTH, (float)TREX_SPRITES_HEIGHT});
+    }
+    for (int frame = 0; frame < spriteImages[TEXTURE_DINO_DUCK].width / TREX_SPRITES_WIDTH_DUCK; frame++)
+    {
+        GetHitboxFrame(TEXTURE_DINO_DUCK, (Rectangle){(float)TREX_SPRITES_WIDTH_DUCK * (float)frame, 0, (float)TREX_SPRITES_WIDTH_DUCK, (float)TREX_SPRITES_HEIGHT_DUCK});
+    }
+    float pterodactylWidth = (float)spriteTextures[TEXTURE_PTERODACTYL].width / 2;
+    for (int frame = 0; frame < 2; frame++)
+    {
+        GetHitboxFrame(TEXTURE_PTERODACTYL, (Rectangle){pterodactylWidth * (float)frame, 0, pterodactylWidth, (float)spriteTextures[TEXTURE_PTERODACTYL].height});
+    }
+
+    // Cacti are cut from a sheet of six, one or two wide, at the offsets
+    // UpdateObstacleTextureSystem picks from
+    int cactusTextures[2] = {TEXTURE_CACTUS_LARGE, TEXTURE_CACTUS_SMALL};
+    int cactusMaxOffsets[2] = {3, 6};
+    for (int k = 0; k < 2; k++)
+    {
+        Texture2D texture = spriteTextures[cactusTextures[k]];
+        for (int offset = 0; offset <= cactusMaxOffsets[k]; offset++)
+        {
+            for (int clusterSize = 1; clusterSize <= 2; clusterSize++)
+            {
+                GetHitboxFrame(cactusTextures[k], (Rectangle){texture.width / 6.0f * (float)offset, 0, texture.width / 6.0f * (float)clusterSize, (float)texture.height});
+            }
+        }
+    }
+}
+
+// Returns the frame's table, building it if it is new, or NULL once the table is full
+const HitboxFrame *GetHitboxFrame(int texture, Rectangle sourceRec)
+{
+    for (int i = 0; i < hitboxTable.count; i++)
+    {
+        const HitboxFrame *frame = &hitboxTable.frames[i];
+        if (frame->texture == texture && frame->sourceRec.x == sourceRec.x && frame->sourceRec.y == sourceRec.y &&
+            frame->sourceRec.width == sourceRec.width && frame->sourceRec.height == sourceRec.height)
+            return frame;
+    }
+    if (hitboxTable.count == MAX_HITBOX_FRAMES)
+        return NULL;
+
+    HitboxFrame *frame = &hitboxTable.frames[hitboxTable.count++];
+    frame->texture = texture;
+    frame->sourceRec = sourceRec;
+    CollisionMask mask = GetCollisionMaskFromImage(spriteImages[texture], sourceRec);
+    frame->count = BuildFrameHitboxes(mask, frame->boxes, MAX_FRAME_HITBOXES);
+    free(mask.pixels);
+    return frame;
+}
+
+// Covers every opaque pixel of the mask with at most maxBoxes boxes. Columns with nothing
+// in them split the frame into strips (the cacti of a cluster, usually), every row of a
+// strip starts out as a box around its opaque pixels, and then whichever neighbouring pair
+// adds the least empty area when merged is merged until few enough are left.
+int BuildFrameHitboxes(CollisionMask mask, Hitbox *boxes, int maxBoxes)
+{
+    bool *isColumnUsed = calloc(mask.width + 1, sizeof(bool));
+    for (int x = 0; x < mask.width; x++)
+    {
+        for (int y = 0; y < mask.height && !isColumnUsed[x]; y++)
+        {
+            isColumnUsed[x] = mask.pixels[x + y * mask.width];
+        }
+    }
+
+    Hitbox *candidates = malloc(((mask.width + 1) / 2 * mask.height + 1) * sizeof(Hitbox));
+    int count = 0;
+    for (int left = 0; left < mask.width; left++)
+    {
+        if (!isColumnUsed[left])
+            continue;
+        int right = left;
+        while (right + 1 < mask.width && isColumnUsed[right + 1])
+        {
+            right++;
+        }
+        for (int y = 0; y < mask.height; y++)
+        {
+            int first = -1;
+            int last = -1;
+            for (int x = left; x <= right; x++)
+            {
+                if (!mask.pixels[x + y * mask.width])
+                    continue;
+                first = first < 0 ? x : first;
+                last = x;
+            }
+            if (first >= 0)
+            {
+                candidates[count++] = (Hitbox){(short)first, (short)y, (short)(last - first + 1), 1};
+            }
+        }
+        left = right;
+    }
+
+    while (count > maxBoxes)
+    {
+        int best = 0;
+        Hitbox bestMerged = {0};
+        int bestCost = 0;
+        for (int k = 0; k + 1 < count; k++)
+        {
+            Hitbox a = candidates[k];
+            Hitbox b = candidates[k + 1];
+            int left = a.x < b.x ? a.x : b.x;
+            int top = a.y < b.y ? a.y : b.y;
+            int right = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+            int bottom = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+            int cost = (right - left) * (bottom - top) - a.width * a.height - b.width * b.height;
+            if (k == 0 || cost < bestCost)
+            {
+                best = k;
+                bestCost = cost;
+                bestMerged = (Hitbox){(short)left, (short)top, (short)(right - left), (short)(bottom - top)};
+            }
+        }
+        candidates[best] = bestMerged;
+        memmove(&candidates[best + 1], &candidates[best + 2], (count - best - 2) * sizeof(Hitbox));
+        count--;
+    }
+
+    memcpy(boxes, candidates, count * sizeof(Hitbox));
+    free(candidates);
+    free(isColumnUsed);
+    return count;
+}
+// ----------------------------------------------------------------------------------
+
+// Input Functions Definition
+// ----------------------------------------------------------------------------------
+bool PushInputEvent(int action, bool isPressed, double timestamp, int tick)
+{
+    if (inputQueue.count >= MAX_INPUT_EVENTS)
+    {
+        TraceLog(LOG_WARNING, "INPUT: Event queue full, dropping event");
+        return false;
+    }
+    int index = (inputQueue.head + inputQueue.count) % MAX_INPUT_EVENTS;
+    inputQueue.events[index] = (InputEvent){action, isPressed, timestamp, tick};
+    inputQueue.count++;
+    return true;
+}
+
+// Applies every event due by tick. Events left for later ticks are packed back to the
+// front of the queue in order.
+void ApplyInputEventsSystem(Entity *entities, int tick)
+{
+    bool isDuckPressedThisTick = false;
+    bool isDuckDeferred = false;
+    int count = inputQueue.count;
+    int kept = 0;
+    for (int n = 0; n < count; n++)
+    {
+        InputEvent *event = &inputQueue.events[(inputQueue.head + n) % MAX_INPUT_EVENTS];
+        // A duck tapped within a single tick still gets one tick of ducking. Only the release
+        // waits, along with any duck events behind it, so a jump in the same tick is not held up.
+        if (event->tick <= tick && event->action == INPUT_DUCK &&
+            (isDuckDeferred || (!event->isPressed && isDuckPressedThisTick)))
+        {
+            event->tick = tick + 1;
+            isDuckDeferred = true;
+        }
+        if (event->tick > tick)
+        {
+            inputQueue.events[(inputQueue.head + kept++) % MAX_INPUT_EVENTS] = *event;
+            continue;
+        }
+
+        for (int i = 0; i < nextEntityId; i++)
+        {
+            if (!HasComponent(entities, i, INPUT))
+                continue;
+            if (event->action == INPUT_JUMP && event->isPressed)
+            {
+                inputComponents[i].jumpPressed = true;
+                if (HasComponent(entities, i, DINO) &&
+                    !inputLatencyStats.isPending &&
+                    positionComponents[i].y >= ToScalar(FLOOR_Y_POS))
+                {
+                    inputLatencyStats.pendingTimestamp = event->timestamp;
+                    inputLatencyStats.isPending = true;
+                }
+            }
+            if (event->action == INPUT_DUCK)
+            {
+                inputComponents[i].duckHeld = event->isPressed;
+            }
+        }
+        if (event->action == INPUT_DUCK && event->isPressed)
+        {
+            isDuckPressedThisTick = true;
+        }
+    }
+    inputQueue.count = kept;
+}
+
+void ClearInputEvents(Entity *entities)
+{
+    inputQueue.head = 0;
+    inputQueue.count = 0;
+    inputLatencyStats.isPending = false;
+    inputLatencyStats.isMeasuring = false;
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, INPUT))
+            continue;
+        inputComponents[i] = (InputComponent){false, false};
+    }
+}
+
+// Call while no tick is running. A jump the simulation noted while one is still being
+// measured is dropped.
+void TakePendingInputLatency()
+{
+    if (!inputLatencyStats.isPending)
+        return;
+    if (!inputLatencyStats.isMeasuring)
+    {
+        inputLatencyStats.measuredTimestamp = inputLatencyStats.pendingTimestamp;
+        inputLatencyStats.isMeasuring = true;
+    }
+    inputLatencyStats.isPending = false;
+}
+
+// Call after presenting a frame, with the dino as that frame showed it. Only touches what
+// the main thread owns, so a tick may be running. Events are stamped when they are polled,
+// so the time between the key going down and the poll is not counted.
+void UpdateInputLatencyStats(bool isDinoDead, bool isDinoAirborne)
+{
+    if (!inputLatencyStats.isMeasuring)
+        return;
+    if (isDinoDead)
+    {
+        inputLatencyStats.isMeasuring = false;
+        return;
+    }
+    if (!isDinoAirborne)
+        return;
+
+    double latency = GetTime() - inputLatencyStats.measuredTimestamp;
+    inputLatencyStats.samples++;
+    inputLatencyStats.totalSeconds += latency;
+    inputLatencyStats.lastSeconds = latency;
+    if (latency > inputLatencyStats.maxSeconds)
+    {
+        inputLatencyStats.maxSeconds = latency;
+    }
+    inputLatencyStats.isMeasuring = false;
+}
+
+void SaveInputLatencyStats(const char *fileName)
+{
+    if (inputLatencyStats.samples == 0)
+        return;
+    const char *text = TextFormat("samples %i\nmean_ms %.3f\nmax_ms %.3f\nlast_ms %.3f\n",
+                                  inputLatencyStats.samples,
+                                  inputLatencyStats.totalSeconds / inputLatencyStats.samples * 1000.0,
+                                  inputLatencyStats.maxSeconds * 1000.0,
+                                  inputLatencyStats.lastSeconds * 1000.0);
+    SaveFileText(fileName, (char *)text);
+}
+// ----------------------------------------------------------------------------------
+
+// Sim Event Functions Definition
+// ----------------------------------------------------------------------------------
+void PushSimEvent(int type, int entity, int other, int value)
+{
+    if (simEventQueue.count >= MAX_SIM_EVENTS)
+    {
+        simEventQueue.head = (simEventQueue.head + 1) % MAX_SIM_EVENTS;
+        simEventQueue.count--;
+    }
+    int index = (simEventQueue.head + simEventQueue.count) % MAX_SIM_EVENTS;
+    simEventQueue.events[index] = (SimEvent){type, simEventQueue.tick, entity, other, value,
+                                             ScalarToFloat(positionComponents[entity].x),
+                                             ScalarToFloat(positionComponents[entity].y)};
+    simEventQueue.count++;
+}
+
+bool PopSimEvent(SimEvent *event)
+{
+    if (simEventQueue.count == 0)
+        return false;
+    *event = simEventQueue.events[simEventQueue.head];
+    simEventQueue.head = (simEventQueue.head + 1) % MAX_SIM_EVENTS;
+    simEventQueue.count--;
+    return true;
+}
+
+void ClearSimEvents()
+{
+    simEventQueue.head = 0;
+    simEventQueue.count = 0;
+    simEventQueue.tick = 0;
+}
+// ----------------------------------------------------------------------------------
+
+// Bot Functions Definition
+// ----------------------------------------------------------------------------------
+// Jumps cacti and ducks pterodactyls once they are within a look-ahead that grows with the
+// scroll speed. Drives the headless runner and the benchmarks.
+void UpdateReflexBot(Entity *entities, GameVariables *game, int dinoId)
+{
+    float lookAhead = 18.0f * 2.5f * ScalarToFloat(game->scrollMultiplier);
+    float dinoRight = ScalarToFloat(positionComponents[dinoId].x) + spriteComponents[dinoId].sourceRec.width;
+    bool isCactusAhead = false;
+    bool isPterodactylAhead = false;
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, OBSTACLE))
+            continue;
+        float distance = ScalarToFloat(positionComponents[i].x) - dinoRight;
+        if (distance < -spriteComponents[i].sourceRec.width - spriteComponents[dinoId].sourceRec.width || distance > lookAhead)
+            continue;
+        if (obstacleComponents[i].type == PTERODACTYL)
+        {
+            isPterodactylAhead = true;
+        }
+        else
+        {
+            isCactusAhead = true;
+        }
+    }
+
+    if (isCactusAhead && !dinoComponents[dinoId].isJumping)
+    {
+        PushInputEvent(INPUT_JUMP, true, 0.0, game->frameCounter);
+    }
+    if (isPterodactylAhead != inputComponents[dinoId].duckHeld)
+    {
+        PushInputEvent(INPUT_DUCK, isPterodactylAhead, 0.0, game->frameCounter);
+    }
+}
+// ----------------------------------------------------------------------------------
+
+// Snapshot Functions Definition
+// ----------------------------------------------------------------------------------
+void WriteSnapshotBytes(unsigned char **cursor, const void *source, size_t size)
+{
+    memcpy(*cursor, source, size);
+    *cursor += size;
+}
+
+void ReadSnapshotBytes(const unsigned char **cursor, void *destination, size_t size)
+{
+    memcpy(destination, *cursor, size);
+    *cursor += size;
+}
+
+int SaveWorldSnapshot(Entity *entities, GameVariables *game, unsigned char *data, int dataSize)
+{
+    int count = nextEntityId;
+    int size = (int)(sizeof(WorldSnapshotHeader) + sizeof(GameVariables) + count * WORLD_SNAPSHOT_ENTITY_SIZE);
+    if (size > dataSize)
+        return 0;
+
+    WorldSnapshotHeader header = {WORLD_SNAPSHOT_MAGIC, WORLD_SNAPSHOT_FORMAT, (unsigned short)count, worldRandomState, (unsigned int)size};
+    unsigned char *cursor = data;
+    WriteSnapshotBytes(&cursor, &header, sizeof(header));
+    WriteSnapshotBytes(&cursor, game, sizeof(GameVariables));
+    WriteSnapshotBytes(&cursor, entities, count * sizeof(Entity));
+    WriteSnapshotBytes(&cursor, positionComponents, count * sizeof(PositionComponent));
+    WriteSnapshotBytes(&cursor, velocityComponents, count * sizeof(VelocityComponent));
+    WriteSnapshotBytes(&cursor, spriteComponents, count * sizeof(SpriteComponent));
+    WriteSnapshotBytes(&cursor, animationComponents, count * sizeof(AnimationComponent));
+    WriteSnapshotBytes(&cursor, dinoComponents, count * sizeof(DinoComponent));
+    WriteSnapshotBytes(&cursor, collisionComponents, count * sizeof(CollisionComponent));
+    WriteSnapshotBytes(&cursor, obstacleComponents, count * sizeof(ObstacleComponent));
+    WriteSnapshotBytes(&cursor, cloudComponents, count * sizeof(CloudComponent));
+    WriteSnapshotBytes(&cursor, inputComponents, count * sizeof(InputComponent));
+    return size;
+}
+
+bool LoadWorldSnapshot(Entity *entities, GameVariables *game, const unsigned char *data, int dataSize)
+{
+    WorldSnapshotHeader header;
+    if (dataSize < (int)sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != WORLD_SNAPSHOT_MAGIC || header.version != WORLD_SNAPSHOT_FORMAT)
+    {
+        TraceLog(LOG_WARNING, "SNAPSHOT: Unknown snapshot format");
+        return false;
+    }
+    int count = header.entityCount;
+    if (count > MAX_ENTITIES || (int)header.size > dataSize ||
+        header.size != sizeof(WorldSnapshotHeader) + sizeof(GameVariables) + count * WORLD_SNAPSHOT_ENTITY_SIZE)
+    {
+        TraceLog(LOG_WARNING, "SNAPSHOT: Snapshot is truncated or corrupt");
+        return false;
+    }
+
+    const unsigned char *cursor = data + sizeof(header);
+    ReadSnapshotBytes(&cursor, game, sizeof(GameVariables));
+    ReadSnapshotBytes(&cursor, entities, count * sizeof(Entity));
+    ReadSnapshotBytes(&cursor, positionComponents, count * sizeof(PositionComponent));
+    ReadSnapshotBytes(&cursor, velocityComponents, count * sizeof(VelocityComponent));
+    ReadSnapshotBytes(&cursor, spriteComponents, count * sizeof(SpriteComponent));
+    ReadSnapshotBytes(&cursor, animationComponents, count * sizeof(AnimationComponent));
+    ReadSnapshotBytes(&cursor, dinoComponents, count * sizeof(DinoComponent));
+    ReadSnapshotBytes(&cursor, collisionComponents, count * sizeof(CollisionComponent));
+    ReadSnapshotBytes(&cursor, obstacleComponents, count * sizeof(ObstacleComponent));
+    ReadSnapshotBytes(&cursor, cloudComponents, count * sizeof(CloudComponent));
+    ReadSnapshotBytes(&cursor, inputComponents, count * sizeof(InputComponent));
+    nextEntityId = count;
+    worldRandomState = header.randomState;
+    return true;
+}
+
+void PushRewindSnapshot(Entity *entities, GameVariables *game)
+{
+    int index = (rewindRing.head + rewindRing.count) % MAX_REWIND_SNAPSHOTS;
+    if (rewindRing.count == MAX_REWIND_SNAPSHOTS)
+    {
+        rewindRing.head = (rewindRing.head + 1) % MAX_REWIND_SNAPSHOTS;
+    }
+    else
+    {
+        rewindRing.count++;
+    }
+    rewindRing.sizes[index] = SaveWorldSnapshot(entities, game, rewindRing.snapshots[index], MAX_WORLD_SNAPSHOT_SIZE);
+}
+
+bool PopRewindSnapshot(Entity *entities, GameVariables *game)
+{
+    if (rewindRing.count == 0)
+        return false;
+    rewindRing.count--;
+    int index = (rewindRing.head + rewindRing.count) % MAX_REWIND_SNAPSHOTS;
+    return LoadWorldSnapshot(entities, game, rewindRing.snapshots[index], rewindRing.sizes[index]);
+}
+
+void ClearRewindSnapshots()
+{
+    rewindRing.head = 0;
+    rewindRing.count = 0;
+}
+
+// xorshift32, kept here instead of raylib's generator so its state can be snapshotted
+void SetWorldRandomSeed(unsigned int seed)
+{
+    worldRandomState = seed != 0 ? seed : 1;
+}
+
+int GetWorldRandomValue(int min, int max)
+{
+    if (min > max)
+    {
+        int tmp = max;
+        max = min;
+        min = tmp;
+    }
+    worldRandomState ^= worldRandomState << 13;
+    worldRandomState ^= worldRandomState >> 17;
+    worldRandomState ^= worldRandomState << 5;
+    return min + (int)(worldRandomState % (unsigned int)(max - min + 1));
+}
+// ----------------------------------------------------------------------------------
+
+// Helper Functions Definition
+// ----------------------------------------------------------------------------------
+// raylib's GetTime() needs a window, so anything that may run without one times itself
+// with the OS clock instead
+double GetWallTime()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+bool IsJumping(int i)
+{
+    if (inputComponents[i].jumpPressed)
+    {
+        return true;
+    }
+    if (positionComponents[i].y < ToScalar(FLOOR_Y_POS))
+    {
+        return true;
+    }
+    return false;
+}
+
+bool IsDucking(int i)
+{
+    if (positionComponents[i].y < ToScalar(FLOOR_Y_POS))
+    {
+        return false;
+    }
+    if (inputComponents[i].duckHeld)
+    {
+        return true;
+    }
+    return false;
+}
+
+bool IsSpriteOverlap(Rectangle rec1, Rectangle rec2)
+{
+    if (CheckCollisionRecs(rec1, rec2))
+    {
+        return true;
+    }
+    return false;
+}
+
+bool IsOutOfBounds(int i)
+{
+    if (positionComponents[i].x < ToScalar(-spriteComponents[i].sourceRec.width - 50))
+    {
+        return true;
+    }
+    return false;
+}
+
+// Cacti are cut from a sheet of six, one or two wide; a pterodactyl is always on its own
+int GetObstacleClusterSize(int i)
+{
+    if (obstacleComponents[i].type == PTERODACTYL)
+        return 1;
+    float cactusWidth = spriteComponents[i].texture.width / 6.0f;
+    return (int)lroundf(spriteComponents[i].sourceRec.width / cactusWidth);
+}
+
+#ifdef DINO_FIXED_POINT
+// sin(2 * PI * turns) for a Q16.16 phase, from an odd polynomial on the first quadrant
+// evaluated in integers only. Within two Q16.16 steps of the real thing.
+Scalar ScalarSinTurns(Scalar turns)
+{
+    int phase = turns & (SCALAR_ONE - 1);
+    int quadrant = phase >> (SCALAR_FRACTION_BITS - 2);
+    int64_t u = (int64_t)(phase & (SCALAR_ONE / 4 - 1)) * 4;
+    if (quadrant & 1)
+    {
+        u = SCALAR_ONE - u;
+    }
+
+    // sin(PI / 2 * u) = u * (c1 - u^2 * (c3 - u^2 * (c5 - u^2 * (c7 - u^2 * c9))))
+    int64_t u2 = (u * u) >> SCALAR_FRACTION_BITS;
+    int64_t result = 10;
+    result = 307 - ((result * u2) >> SCALAR_FRACTION_BITS);
+    result = 5223 - ((result * u2) >> SCALAR_FRACTION_BITS);
+    result = 42334 - ((result * u2) >> SCALAR_FRACTION_BITS);
+    result = 102944 - ((result * u2) >> SCALAR_FRACTION_BITS);
+    result = (result * u) >> SCALAR_FRACTION_BITS;
+    return (Scalar)(quadrant >= 2 ? -result : result);
+}
+#endif
+
+int GetSpriteTextureIndex(Texture2D texture)
+{
+    for (int i = 0; i < SPRITE_TEXTURE_COUNT; i++)
+    {
+        if (spriteTextures[i].id == texture.id)
+            return i;
+    }
+    return -1;
+}
+// ----------------------------------------------------------------------------------
+
+// Entity Component System: Functions
+// ----------------------------------------------------------------------------------
+Entity CreateEntity()
+{
+    Entity e = {nextEntityId++, 0};
+    return e;
+}
+
+bool HasComponent(Entity *entities, int id, int component)
+{
+    return entities[id].componentMask & component;
+}
+
+void AddComponent(Entity *entities, int id, int component)
+{
+    entities[id].componentMask |= component;
+}
+
+void RemoveComponent(Entity *entities, int id, int component)
+{
+    entities[id].componentMask &= ~component;
+}
+// ----------------------------------------------------------------------------------
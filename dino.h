@@ -0,0 +1,459 @@
+/*******************************************************************************************
+ *
+ *   Dino simulation library
+ *   Entities, components and systems of the Dino Game, without a window or input device.
+ *   Linked into the game, the headless runner and the benchmarks.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+#ifndef DINO_H
+#define DINO_H
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+#define MAX_ENTITIES 99
+#define MAX_INPUT_EVENTS 64
+#define MAX_REWIND_SNAPSHOTS 300
+#define MAX_SIM_EVENTS 256
+#define WORLD_SNAPSHOT_MAGIC 0x534e4944
+#define WORLD_SNAPSHOT_VERSION 1
+extern const int MAX_FRAME_SPEED;
+extern const int MIN_FRAME_SPEED;
+extern const int FPS;
+extern const int MAX_CLOUDS;
+extern const int MAX_OBSTACLE_LENGTH;
+extern const int MAX_OBSTACLE_DUPLICATION;
+extern const int MAX_SPEED;
+extern const int SPEED;
+extern const int HEIGHT;
+extern const int WIDTH;
+extern const int TREX_SPRITES_WIDTH;
+extern const int TREX_SPRITES_HEIGHT;
+extern const int TREX_SPRITES_WIDTH_DUCK;
+extern const int TREX_SPRITES_HEIGHT_DUCK;
+extern const int CACTUS_LARGE_SPRITE_X;
+extern const int CACTUS_LARGE_SPRITE_Y;
+extern const int CACTUS_LARGE_SPRITE_WIDTH;
+extern const int CACTUS_LARGE_SPRITE_HEIGHT;
+extern const int CACTUS_SMALL_SPRITE_X;
+extern const int CACTUS_SMALL_SPRITE_Y;
+extern const int CACTUS_SMALL_SPRITE_WIDTH;
+extern const int CACTUS_SMALL_SPRITE_HEIGHT;
+extern const int CLOUD_SPRITE_X;
+extern const int CLOUD_SPRITE_Y;
+extern const int CLOUD_SPRITE_WIDTH;
+extern const int CLOUD_SPRITE_HEIGHT;
+extern const int HORIZON_SPRITE_X;
+extern const int HORIZON_SPRITE_Y;
+extern const int HORIZON_SPRITE_WIDTH;
+extern const int PTERODACTYL_SPRITE_X;
+extern const int PTERODACTYL_SPRITE_Y;
+extern const int PTERODACTYL_SPRITE_WIDTH;
+extern const int PTERODACTYL_SPRITE_HEIGHT;
+extern const float FLOOR_Y_POS;
+extern const float JUMP_Y_POS;
+extern const float INITIAL_JUMP_VELOCITY;
+extern const float DROP_VELOCITY;
+extern const float DINO_START_X_POS;
+extern const float DINO_PLAY_X_POS;
+extern const int MAX_OBSTACLES;
+
+enum ComponentsEnum
+{
+    CLOUD = 0b00000001,
+    POSITION = 0b00000010,
+    VELOCITY = 0b00000100,
+    SPRITE = 0b00001000,
+    ANIMATION = 0b00010000,
+    DINO = 0b00100000,
+    COLLISION = 0b01000000,
+    OBSTACLE = 0b10000000,
+    INPUT = 0b100000000,
+};
+
+enum GameState
+{
+    MENU,
+    PLAYING,
+    GAMEOVER,
+    SPECTATING
+};
+
+enum ObstacleType
+{
+    CACTUS_LARGE,
+    CACTUS_SMALL,
+    PTERODACTYL
+};
+
+enum SpriteTexture
+{
+    TEXTURE_DINO,
+    TEXTURE_DINO_DUCK,
+    TEXTURE_PTERODACTYL,
+    TEXTURE_CACTUS_LARGE,
+    TEXTURE_CACTUS_SMALL,
+    TEXTURE_CLOUD,
+    TEXTURE_HORIZON,
+    SPRITE_TEXTURE_COUNT
+};
+
+enum InputAction
+{
+    INPUT_JUMP,
+    INPUT_DUCK
+};
+
+extern int nextEntityId;
+extern unsigned int worldRandomState;
+//----------------------------------------------------------------------------------
+
+// Simulation Scalar
+//----------------------------------------------------------------------------------
+// Positions, velocities and the scroll speed. Built with DINO_FIXED_POINT they are Q16.16
+// integers and the jump curve uses an integer sine, so a run produces the same bits on every
+// x86-64 build; otherwise they are floats. Convert to float only to draw or send them.
+#ifdef DINO_FIXED_POINT
+typedef int32_t Scalar;
+#define SCALAR_FRACTION_BITS 16
+#define SCALAR_ONE (1 << SCALAR_FRACTION_BITS)
+#define ToScalar(value) ((Scalar)lroundf((value) * (float)SCALAR_ONE))
+#define ScalarFromInt(value) ((Scalar)((value) * SCALAR_ONE))
+#define ScalarToFloat(value) ((float)(value) / (float)SCALAR_ONE)
+#define ScalarToInt(value) ((int)((value) / SCALAR_ONE))
+#define ScalarMul(a, b) ((Scalar)(((int64_t)(a) * (int64_t)(b)) >> SCALAR_FRACTION_BITS))
+#define ScalarDiv(a, b) ((Scalar)(((int64_t)(a) * SCALAR_ONE) / (b)))
+#else
+typedef float Scalar;
+#define ToScalar(value) ((float)(value))
+#define ScalarFromInt(value) ((float)(value))
+#define ScalarToFloat(value) (value)
+#define ScalarToInt(value) ((int)(value))
+#define ScalarMul(a, b) ((a) * (b))
+#define ScalarDiv(a, b) ((a) / (b))
+#endif
+//----------------------------------------------------------------------------------
+
+// Entity Component System
+// ----------------------------------------------------------------------------------
+typedef struct PositionComponent
+{
+    Scalar x, y;
+} PositionComponent;
+extern PositionComponent positionComponents[MAX_ENTITIES];
+
+typedef struct VelocityComponent
+{
+    Scalar x, y;
+} VelocityComponent;
+extern VelocityComponent velocityComponents[MAX_ENTITIES];
+
+typedef struct SpriteComponent
+{
+    Texture2D texture;
+    Rectangle sourceRec;
+} SpriteComponent;
+extern SpriteComponent spriteComponents[MAX_ENTITIES];
+
+typedef struct AnimationComponent
+{
+    int currentFrameIndex;
+    int frameIndexSlice[2];
+    int framesSpeed;
+    int framesCounter;
+} AnimationComponent;
+extern AnimationComponent animationComponents[MAX_ENTITIES];
+
+typedef struct DinoComponent
+{
+    bool isDucking;
+    bool isJumping;
+    bool isDead;
+    int jumpFrameCount;
+    int slideFrameCount;
+} DinoComponent;
+extern DinoComponent dinoComponents[MAX_ENTITIES];
+
+typedef struct CollisionComponent
+{
+    Rectangle collisionRec;
+} CollisionComponent;
+extern CollisionComponent collisionComponents[MAX_ENTITIES];
+
+typedef struct ObstacleComponent
+{
+    int type;
+    int xIndex;
+} ObstacleComponent;
+extern ObstacleComponent obstacleComponents[MAX_ENTITIES];
+
+typedef struct CloudComponent
+{
+    int xIndex, yIndex;
+} CloudComponent;
+extern CloudComponent cloudComponents[MAX_ENTITIES];
+
+typedef struct InputComponent
+{
+    bool jumpPressed;
+    bool duckHeld;
+} InputComponent;
+extern InputComponent inputComponents[MAX_ENTITIES];
+
+typedef struct Entity
+{
+    int id;
+    int componentMask;
+} Entity;
+
+typedef struct CollisionMask
+{
+    int width, height;
+    bool *pixels;
+} CollisionMask;
+
+// Pixel collision tests the two sprites' alpha masks. Box collision tests a few boxes per
+// sprite frame, derived from the same masks at load time, and can only err by reporting a
+// hit where the masks just miss. Compare decides with pixels and counts where boxes differ.
+typedef enum CollisionMode
+{
+    COLLISION_PIXELS,
+    COLLISION_BOXES,
+    COLLISION_COMPARE
+} CollisionMode;
+
+#define MAX_FRAME_HITBOXES 8
+#define MAX_HITBOX_FRAMES 64
+
+// In pixels from the top left of the frame
+typedef struct Hitbox
+{
+    short x, y, width, height;
+} Hitbox;
+
+typedef struct HitboxFrame
+{
+    int texture;
+    Rectangle sourceRec;
+    int count;
+    Hitbox boxes[MAX_FRAME_HITBOXES];
+} HitboxFrame;
+
+typedef struct HitboxTable
+{
+    HitboxFrame frames[MAX_HITBOX_FRAMES];
+    int count;
+} HitboxTable;
+
+// Narrow phase tests only: pairs whose sprite rectangles overlap
+typedef struct CollisionStats
+{
+    long long tests;
+    long long pixelHits;
+    long long boxHits;
+    long long disagreements;
+} CollisionStats;
+
+typedef struct InputEvent
+{
+    int action;
+    bool isPressed;
+    double timestamp;
+    int tick;
+} InputEvent;
+
+// Ring buffer of key presses/releases waiting for the simulation tick they belong to.
+typedef struct InputQueue
+{
+    InputEvent events[MAX_INPUT_EVENTS];
+    int head;
+    int count;
+} InputQueue;
+extern InputQueue inputQueue;
+
+// Time from polling a jump press to the first presented frame where the dino has left the
+// floor. Whatever the OS and raylib spend before the poll is not included.
+// The simulation sets the pending jump; the main thread takes it over while it owns the
+// world and measures it from then on, so the two never touch the same fields at once.
+typedef struct InputLatencyStats
+{
+    int samples;
+    double totalSeconds;
+    double maxSeconds;
+    double lastSeconds;
+    double pendingTimestamp;
+    bool isPending;
+    double measuredTimestamp;
+    bool isMeasuring;
+} InputLatencyStats;
+extern InputLatencyStats inputLatencyStats;
+
+// Things that happened during a tick that something outside the simulation may react to.
+// entity is the dino unless noted; x and y are its position when the event was raised.
+typedef enum SimEventType
+{
+    SIM_EVENT_LAND,
+    SIM_EVENT_DUCK,
+    SIM_EVENT_HIT,   // other: the obstacle entity, value: its ObstacleType
+    SIM_EVENT_JUMP,
+    SIM_EVENT_STAND, // let go of duck
+    SIM_EVENT_SPAWN, // entity: an obstacle coming on from the right, other: its ObstacleType, value: cluster size
+} SimEventType;
+
+typedef struct SimEvent
+{
+    int type;
+    int tick;
+    int entity;
+    int other;
+    int value;
+    float x, y;
+} SimEvent;
+
+// Ring buffer of events waiting to be drained. When nobody drains it (headless runs) the
+// oldest events are overwritten.
+typedef struct SimEventQueue
+{
+    SimEvent events[MAX_SIM_EVENTS];
+    int head;
+    int count;
+    int tick;
+} SimEventQueue;
+extern SimEventQueue simEventQueue;
+
+typedef struct GameVariables
+{
+    int frameCounter;
+    int score;
+    Scalar scrollMultiplier;
+    Scalar scrollIndex;
+} GameVariables;
+
+// Snapshots are raw copies of the first entityCount slots of every component array. They
+// hold texture handles, so a snapshot is only meaningful inside the process that took it.
+// Padding is copied too: CreateWorld clears the arrays, and components with padding
+// (DinoComponent) are filled a field at a time rather than from compound literals.
+typedef struct WorldSnapshotHeader
+{
+    unsigned int magic;
+    unsigned short version;
+    unsigned short entityCount;
+    unsigned int randomState;
+    unsigned int size;
+} WorldSnapshotHeader;
+
+#define WORLD_SNAPSHOT_ENTITY_SIZE (sizeof(Entity) + sizeof(PositionComponent) + sizeof(VelocityComponent) + \
+                                    sizeof(SpriteComponent) + sizeof(AnimationComponent) + sizeof(DinoComponent) + \
+                                    sizeof(CollisionComponent) + sizeof(ObstacleComponent) + sizeof(CloudComponent) + \
+                                    sizeof(InputComponent))
+// Fixed and float builds lay scalars out the same way but cannot read each other's snapshots
+#ifdef DINO_FIXED_POINT
+#define WORLD_SNAPSHOT_FORMAT (WORLD_SNAPSHOT_VERSION | 0x8000)
+#else
+#define WORLD_SNAPSHOT_FORMAT WORLD_SNAPSHOT_VERSION
+#endif
+#define MAX_WORLD_SNAPSHOT_SIZE (sizeof(WorldSnapshotHeader) + sizeof(GameVariables) + MAX_ENTITIES * WORLD_SNAPSHOT_ENTITY_SIZE)
+
+// The last MAX_REWIND_SNAPSHOTS ticks, oldest overwritten first.
+typedef struct RewindRing
+{
+    unsigned char snapshots[MAX_REWIND_SNAPSHOTS][MAX_WORLD_SNAPSHOT_SIZE];
+    int sizes[MAX_REWIND_SNAPSHOTS];
+    int head;
+    int count;
+} RewindRing;
+extern RewindRing rewindRing;
+
+// Textures that sprites may reference, so they can be named by index outside this process.
+// The CPU-side images are kept for collision masks, which lets the simulation run without a GPU.
+extern Texture2D spriteTextures[SPRITE_TEXTURE_COUNT];
+extern Image spriteImages[SPRITE_TEXTURE_COUNT];
+extern HitboxTable hitboxTable;
+extern CollisionMode collisionMode;
+extern CollisionStats collisionStats;
+//----------------------------------------------------------------------------------
+
+// Functions Declaration
+//----------------------------------------------------------------------------------
+Entity CreateEntity();
+bool HasComponent(Entity *entities, int id, int component);
+void AddComponent(Entity *entities, int id, int component);
+void RemoveComponent(Entity *entities, int id, int component);
+
+void LoadSpriteTextures(bool isHeadless);
+void UnloadSpriteTextures(bool isHeadless);
+int CreateWorld(Entity *entities, GameVariables *game);
+void UpdateWorld(Entity *entities, GameVariables *game);
+void RestartWorld(Entity *entities, GameVariables *game, const unsigned char *startSnapshot, int startSnapshotSize, unsigned int seed);
+
+void UpdateDinoAnimationSystem(Entity *entities, Texture2D dinoTexture, Texture2D dinoDuckTexture);
+void UpdateDinoPoseSystem(Entity *entities);
+void UpdatePositionSystem(Entity *entities, Scalar scrollIndex);
+void UpdateVelocitySystem(Entity *entities, Scalar scrollMultiplier);
+void UpdateDinoVelocity(int i, Scalar scrollMultiplier);
+void UpdateCloudVelocity(int i, Scalar scrollMultiplier);
+void UpdateObstacleVelocity(int i, Scalar scrollMultiplier);
+void UpdateDinoPosition(int i);
+void UpdateCloudPosition(int i, Scalar scrollIndex);
+void UpdateObstaclePosition(int i, Scalar scrollIndex);
+void UpdateFrameCounterSystem(Entity *entities);
+void UpdateCurrentFrameIndexSystem(Entity *entities);
+void UpdateObstacleTypeSystem(Entity *entities);
+void UpdateCollisionSystem(Entity *entities);
+void UpdateObstacleTextureSystem(Entity *entities, Texture2D cactusLargeTexture, Texture2D cactusSmallTexture, Texture2D pterodactylTexture);
+bool IsCollisionMaskOverlap(int i, int j);
+CollisionMask GetCollisionMaskFromSprite(int i);
+CollisionMask GetCollisionMaskFromImage(Image sheet, Rectangle sourceRec);
+bool IsCollisionOverlap(int i, int j);
+bool IsHitboxOverlap(int i, int j);
+void BuildHitboxTable();
+const HitboxFrame *GetHitboxFrame(int texture, Rectangle sourceRec);
+int BuildFrameHitboxes(CollisionMask mask, Hitbox *boxes, int maxBoxes);
+int GetSpriteTextureIndex(Texture2D texture);
+
+bool PushInputEvent(int action, bool isPressed, double timestamp, int tick);
+void ApplyInputEventsSystem(Entity *entities, int tick);
+void ClearInputEvents(Entity *entities);
+void TakePendingInputLatency();
+void UpdateInputLatencyStats(bool isDinoDead, bool isDinoAirborne);
+void SaveInputLatencyStats(const char *fileName);
+void PushSimEvent(int type, int entity, int other, int value);
+bool PopSimEvent(SimEvent *event);
+void ClearSimEvents();
+void UpdateReflexBot(Entity *entities, GameVariables *game, int dinoId);
+
+void WriteSnapshotBytes(unsigned char **cursor, const void *source, size_t size);
+void ReadSnapshotBytes(const unsigned char **cursor, void *destination, size_t size);
+int SaveWorldSnapshot(Entity *entities, GameVariables *game, unsigned char *data, int dataSize);
+bool LoadWorldSnapshot(Entity *entities, GameVariables *game, const unsigned char *data, int dataSize);
+void PushRewindSnapshot(Entity *entities, GameVariables *game);
+bool PopRewindSnapshot(Entity *entities, GameVariables *game);
+void ClearRewindSnapshots();
+void SetWorldRandomSeed(unsigned int seed);
+int GetWorldRandomValue(int min, int max);
+
+double GetWallTime();
+bool IsJumping(int i);
+bool IsDucking(int i);
+bool IsSpriteOverlap(Rectangle rec1, Rectangle rec2);
+bool IsOutOfBounds(int i);
+int GetObstacleClusterSize(int i);
+#ifdef DINO_FIXED_POINT
+Scalar ScalarSinTurns(Scalar turns);
+#endif
+//----------------------------------------------------------------------------------
+
+#endif // DINO_H
@@ -0,0 +1,376 @@
+/*******************************************************************************************
+ *
+ *   Dino ghosts
+ *   Recording, the ghost file and playback.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "ghost.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+const unsigned char GHOST_ALPHA = 96;
+//----------------------------------------------------------------------------------
+
+// Local Functions Declaration
+//----------------------------------------------------------------------------------
+FILE *OpenGhostFile(const char *fileName, long *fileSize);
+bool ReadGhostRunHeader(FILE *file, long fileSize, GhostRunHeader *header);
+bool ReserveGhostLayer(GhostLayer *layer, int capacity);
+void StepGhost(GhostLayer *layer, int i, int steps);
+//----------------------------------------------------------------------------------
+
+// Recording Functions Definition
+// ----------------------------------------------------------------------------------
+void StartGhostRecording(GhostRecorder *recorder, unsigned int seed)
+{
+    recorder->run.seed = seed;
+    recorder->run.tickCount = 0;
+    recorder->run.size = 0;
+    recorder->isValid = true;
+}
+
+// Call once per tick, after UpdateWorld
+void RecordGhostSample(GhostRecorder *recorder, int dinoId)
+{
+    if (recorder->run.size + 5 > recorder->capacity)
+    {
+        int capacity = recorder->capacity > 0 ? recorder->capacity * 2 : 4096;
+        unsigned char *data = realloc(recorder->run.data, capacity);
+        if (data == NULL)
+        {
+            TraceLog(LOG_WARNING, "GHOST: Out of memory, dropping the recording");
+            recorder->isValid = false;
+            return;
+        }
+        recorder->run.data = data;
+        recorder->capacity = capacity;
+    }
+
+    int x = (int)lroundf(ScalarToFloat(positionComponents[dinoId].x));
+    int y = (int)lroundf(ScalarToFloat(positionComponents[dinoId].y));
+    SpriteComponent *sprite = &spriteComponents[dinoId];
+    unsigned char pose = (int)(sprite->sourceRec.x / sprite->sourceRec.width) & GHOST_POSE_FRAME;
+    if (sprite->texture.id == spriteTextures[TEXTURE_DINO_DUCK].id)
+    {
+        pose |= GHOST_POSE_DUCK;
+    }
+
+    unsigned char *cursor = recorder->run.data + recorder->run.size;
+    int dx = x - recorder->lastX;
+    int dy = y - recorder->lastY;
+    if (recorder->run.tickCount == 0 || dx < -128 || dx > 127 || dy < -128 || dy > 127)
+    {
+        *cursor++ = pose | GHOST_SAMPLE_ABSOLUTE;
+        *cursor++ = (unsigned char)(x & 0xff);
+        *cursor++ = (unsigned char)((x >> 8) & 0xff);
+        *cursor++ = (unsigned char)(y & 0xff);
+        *cursor++ = (unsigned char)((y >> 8) & 0xff);
+    }
+    else if (dx == 0 && dy == 0)
+    {
+        *cursor++ = pose | GHOST_SAMPLE_STILL;
+    }
+    else
+    {
+        *cursor++ = pose;
+        *cursor++ = (unsigned char)(signed char)dx;
+        *cursor++ = (unsigned char)(signed char)dy;
+    }
+    recorder->run.size = (int)(cursor - recorder->run.data);
+    recorder->run.tickCount++;
+    recorder->lastX = x;
+    recorder->lastY = y;
+}
+
+// A run that was rewound no longer matches what its seed plays out to, so it is not kept
+void InvalidateGhostRecording(GhostRecorder *recorder)
+{
+    recorder->isValid = false;
+}
+
+void UnloadGhostRecording(GhostRecorder *recorder)
+{
+    free(recorder->run.data);
+    *recorder = (GhostRecorder){0};
+}
+// ----------------------------------------------------------------------------------
+
+// Ghost File Functions Definition
+// ----------------------------------------------------------------------------------
+bool SaveGhostRun(const char *fileName, const GhostRun *run)
+{
+    if (run->tickCount == 0)
+        return false;
+
+    FILE *file = fopen(fileName, "ab");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "GHOST: Could not open %s for appending", fileName);
+        return false;
+    }
+    GhostRunHeader header = {GHOST_FILE_MAGIC, GHOST_FILE_VERSION, 0, run->seed, run->tickCount, run->size};
+    bool isSaved = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(run->data, 1, run->size, file) == (size_t)run->size;
+    fclose(file);
+    if (!isSaved)
+    {
+        TraceLog(LOG_WARNING, "GHOST: Could not write to %s", fileName);
+    }
+    return isSaved;
+}
+
+bool GetLastGhostSeed(const char *fileName, unsigned int *seed)
+{
+    long fileSize = 0;
+    FILE *file = OpenGhostFile(fileName, &fileSize);
+    if (file == NULL)
+        return false;
+
+    bool isFound = false;
+    GhostRunHeader header;
+    while (ReadGhostRunHeader(file, fileSize, &header) && fseek(file, header.size, SEEK_CUR) == 0)
+    {
+        *seed = header.seed;
+        isFound = true;
+    }
+    fclose(file);
+    return isFound;
+}
+
+// Adds every run recorded on seed to the layer and returns how many there were. The file is
+// read a run at a time, and runs on other seeds are skipped without being read.
+int LoadGhostRuns(GhostLayer *layer, const char *fileName, unsigned int seed)
+{
+    long fileSize = 0;
+    FILE *file = OpenGhostFile(fileName, &fileSize);
+    if (file == NULL)
+        return 0;
+
+    unsigned char *data = NULL;
+    int capacity = 0;
+    int loaded = 0;
+    GhostRunHeader header;
+    while (ftell(file) < fileSize)
+    {
+        if (!ReadGhostRunHeader(file, fileSize, &header))
+        {
+            TraceLog(LOG_WARNING, "GHOST: %s is damaged after %i runs, ignoring the rest", fileName, loaded);
+            break;
+        }
+        if (header.seed != seed)
+        {
+            fseek(file, header.size, SEEK_CUR);
+            continue;
+        }
+        if (header.size > capacity)
+        {
+            unsigned char *grown = realloc(data, header.size);
+            if (grown == NULL)
+            {
+                TraceLog(LOG_WARNING, "GHOST: Out of memory after %i runs, ignoring the rest", loaded);
+                break;
+            }
+            data = grown;
+            capacity = header.size;
+        }
+        if (fread(data, 1, header.size, file) != (size_t)header.size)
+        {
+            TraceLog(LOG_WARNING, "GHOST: Could not read %s after %i runs, ignoring the rest", fileName, loaded);
+            break;
+        }
+        if (!AddGhostRun(layer, &(GhostRun){header.seed, header.tickCount, header.size, data}))
+            break;
+        loaded++;
+    }
+    free(data);
+    fclose(file);
+    return loaded;
+}
+// ----------------------------------------------------------------------------------
+
+// Playback Functions Definition
+// ----------------------------------------------------------------------------------
+// Copies the run, so the recorder can carry on with the next one. Returns false, leaving
+// the layer as it was, when there is no memory for it.
+bool AddGhostRun(GhostLayer *layer, const GhostRun *run)
+{
+    unsigned char *data = malloc(run->size > 0 ? run->size : 1);
+    if (data == NULL || (layer->count == layer->capacity &&
+                         !ReserveGhostLayer(layer, layer->capacity > 0 ? layer->capacity * 2 : 64)))
+    {
+        TraceLog(LOG_WARNING, "GHOST: Out of memory, dropping a run of %i ticks", run->tickCount);
+        free(data);
+        return false;
+    }
+    memcpy(data, run->data, run->size);
+    int i = layer->count++;
+    layer->runs[i] = *run;
+    layer->runs[i].data = data;
+    layer->cursors[i] = 0;
+    layer->x[i] = 0;
+    layer->y[i] = 0;
+    layer->poses[i] = GHOST_POSE_HIDDEN;
+
+    // Golden-angle hues keep neighbouring ghosts apart however many there are
+    Color tint = ColorFromHSV(fmodf((float)i * 137.508f, 360.0f), 0.6f, 0.85f);
+    tint.a = GHOST_ALPHA;
+    layer->tints[i] = tint;
+
+    // Bring the new ghost up to where the others are
+    StepGhost(layer, i, layer->tick);
+    return true;
+}
+
+// Moves every ghost on to the sample for the given number of ticks. Going backwards
+// (a rewind or a restart) replays from the start.
+void UpdateGhostLayer(GhostLayer *layer, int tick)
+{
+    if (tick < layer->tick)
+    {
+        for (int i = 0; i < layer->count; i++)
+        {
+            layer->cursors[i] = 0;
+            layer->poses[i] = GHOST_POSE_HIDDEN;
+        }
+        layer->tick = 0;
+    }
+    int steps = tick - layer->tick;
+    if (steps == 0)
+        return;
+
+    for (int i = 0; i < layer->count; i++)
+    {
+        StepGhost(layer, i, steps);
+    }
+    layer->tick = tick;
+}
+
+void UnloadGhostLayer(GhostLayer *layer)
+{
+    for (int i = 0; i < layer->count; i++)
+    {
+        free(layer->runs[i].data);
+    }
+    free(layer->runs);
+    free(layer->cursors);
+    free(layer->x);
+    free(layer->y);
+    free(layer->poses);
+    free(layer->tints);
+    *layer = (GhostLayer){0};
+}
+// ----------------------------------------------------------------------------------
+
+// Helper Functions Definition
+// ----------------------------------------------------------------------------------
+FILE *OpenGhostFile(const char *fileName, long *fileSize)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    *fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    return file;
+}
+
+// Reads the next header, and whether it belongs to a run that is all there
+bool ReadGhostRunHeader(FILE *file, long fileSize, GhostRunHeader *header)
+{
+    if (fread(header, sizeof(*header), 1, file) != 1)
+        return false;
+    return header->magic == GHOST_FILE_MAGIC && header->version == GHOST_FILE_VERSION &&
+           header->size >= 0 && header->size <= fileSize - ftell(file);
+}
+
+// Grows the arrays one at a time. Any that did grow are kept when a later one fails, since
+// they still hold everything, and capacity only moves once all of them have.
+bool ReserveGhostLayer(GhostLayer *layer, int capacity)
+{
+    GhostRun *runs = realloc(layer->runs, capacity * sizeof(GhostRun));
+    if (runs == NULL)
+        return false;
+    layer->runs = runs;
+    int *cursors = realloc(layer->cursors, capacity * sizeof(int));
+    if (cursors == NULL)
+        return false;
+    layer->cursors = cursors;
+    short *x = realloc(layer->x, capacity * sizeof(short));
+    if (x == NULL)
+        return false;
+    layer->x = x;
+    short *y = realloc(layer->y, capacity * sizeof(short));
+    if (y == NULL)
+        return false;
+    layer->y = y;
+    unsigned char *poses = realloc(layer->poses, capacity * sizeof(unsigned char));
+    if (poses == NULL)
+        return false;
+    layer->poses = poses;
+    Color *tints = realloc(layer->tints, capacity * sizeof(Color));
+    if (tints == NULL)
+        return false;
+    layer->tints = tints;
+    layer->capacity = capacity;
+    return true;
+}
+
+void StepGhost(GhostLayer *layer, int i, int steps)
+{
+    const unsigned char *data = layer->runs[i].data;
+    int size = layer->runs[i].size;
+    int cursor = layer->cursors[i];
+    int x = layer->x[i];
+    int y = layer->y[i];
+    unsigned char pose = layer->poses[i];
+
+    for (int step = 0; step < steps; step++)
+    {
+        if (cursor >= size)
+        {
+            pose = GHOST_POSE_HIDDEN;
+            break;
+        }
+        // A run cut off mid-sample ends the ghost there rather than reading past it
+        unsigned char bits = data[cursor];
+        int sampleSize = (bits & GHOST_SAMPLE_ABSOLUTE) ? 5 : (bits & GHOST_SAMPLE_STILL) ? 1 : 3;
+        if (cursor + sampleSize > size)
+        {
+            cursor = size;
+            pose = GHOST_POSE_HIDDEN;
+            break;
+        }
+        cursor++;
+        if (bits & GHOST_SAMPLE_ABSOLUTE)
+        {
+            x = (short)(data[cursor] | (data[cursor + 1] << 8));
+            y = (short)(data[cursor + 2] | (data[cursor + 3] << 8));
+            cursor += 4;
+        }
+        else if (!(bits & GHOST_SAMPLE_STILL))
+        {
+            x += (signed char)data[cursor];
+            y += (signed char)data[cursor + 1];
+            cursor += 2;
+        }
+        pose = bits & (GHOST_POSE_FRAME | GHOST_POSE_DUCK);
+    }
+
+    layer->cursors[i] = cursor;
+    layer->x[i] = (short)x;
+    layer->y[i] = (short)y;
+    layer->poses[i] = pose;
+}
+// ----------------------------------------------------------------------------------
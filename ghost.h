@@ -0,0 +1,101 @@
+/*******************************************************************************************
+ *
+ *   Dino ghosts
+ *   Records the dino's position and pose every tick of a run, appends finished runs to a
+ *   file, and plays any number of them back alongside a live run on the same seed.
+ *
+ *   A run is a byte stream with one sample per tick. The first byte of a sample is the pose
+ *   plus flags: a still sample is that byte alone, a moved one adds signed byte deltas for x
+ *   and y, and anything further (or the first sample) carries absolute 16-bit x and y.
+ *   Running along the floor costs one byte a tick.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+#ifndef GHOST_H
+#define GHOST_H
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+#define GHOST_FILE_MAGIC 0x54534847 // "GHST"
+#define GHOST_FILE_VERSION 1
+extern const unsigned char GHOST_ALPHA;
+
+enum GhostSampleBits
+{
+    GHOST_POSE_FRAME = 0b00000111,
+    GHOST_POSE_DUCK = 0b00001000,
+    GHOST_POSE_HIDDEN = 0b00010000,
+    GHOST_SAMPLE_STILL = 0b01000000,
+    GHOST_SAMPLE_ABSOLUTE = 0b10000000,
+};
+//----------------------------------------------------------------------------------
+
+// Ghost Types
+//----------------------------------------------------------------------------------
+typedef struct GhostRunHeader
+{
+    unsigned int magic;
+    unsigned short version;
+    unsigned short reserved;
+    unsigned int seed;
+    int tickCount;
+    int size;
+} GhostRunHeader;
+
+typedef struct GhostRun
+{
+    unsigned int seed;
+    int tickCount;
+    int size;
+    unsigned char *data;
+} GhostRun;
+
+typedef struct GhostRecorder
+{
+    GhostRun run;
+    int capacity;
+    int lastX, lastY;
+    bool isValid;
+} GhostRecorder;
+
+// Playback for every loaded run, one array per field. tick is how many samples each ghost
+// has consumed; a ghost whose run has ended is flagged GHOST_POSE_HIDDEN.
+typedef struct GhostLayer
+{
+    GhostRun *runs;
+    int count;
+    int capacity;
+    int tick;
+    int *cursors;
+    short *x;
+    short *y;
+    unsigned char *poses;
+    Color *tints;
+} GhostLayer;
+//----------------------------------------------------------------------------------
+
+// Functions Declaration
+//----------------------------------------------------------------------------------
+void StartGhostRecording(GhostRecorder *recorder, unsigned int seed);
+void RecordGhostSample(GhostRecorder *recorder, int dinoId);
+void InvalidateGhostRecording(GhostRecorder *recorder);
+void UnloadGhostRecording(GhostRecorder *recorder);
+bool SaveGhostRun(const char *fileName, const GhostRun *run);
+bool GetLastGhostSeed(const char *fileName, unsigned int *seed);
+int LoadGhostRuns(GhostLayer *layer, const char *fileName, unsigned int seed);
+bool AddGhostRun(GhostLayer *layer, const GhostRun *run);
+void UpdateGhostLayer(GhostLayer *layer, int tick);
+void UnloadGhostLayer(GhostLayer *layer);
+//----------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,136 @@
+/*******************************************************************************************
+ *
+ *   Dino headless runner
+ *   Plays the simulation without a window, driven by the reflex bot, and prints how the runs
+ *   went and how long a tick took.
+ *
+ *   Usage: dino_headless [--boxes | --compare] [ticks] [seed] [telemetry file]
+ *   --boxes collides with the hitbox tables instead of the sprite masks. --compare collides
+ *   with the masks but tests the boxes too, and reports how often they disagreed. The runs
+ *   it compares on are the bot's, on seeds seed, seed + 1 and so on, so the same arguments
+ *   always test the same courses and moves.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//----------------------------------------------------------------------------------
+
+// Main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    // Initialization
+    //--------------------------------------------------------------------------------------
+    const char *positional[3] = {NULL};
+    int positionalCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--boxes") == 0)
+        {
+            collisionMode = COLLISION_BOXES;
+        }
+        else if (strcmp(argv[i], "--compare") == 0)
+        {
+            collisionMode = COLLISION_COMPARE;
+        }
+        else if (positionalCount < 3)
+        {
+            positional[positionalCount++] = argv[i];
+        }
+    }
+    int ticks = positional[0] != NULL ? atoi(positional[0]) : 100000;
+    unsigned int seed = positional[1] != NULL ? (unsigned int)strtoul(positional[1], NULL, 10) : 1;
+    TelemetryLog telemetry = {0};
+    if (positional[2] != NULL)
+    {
+        OpenTelemetryLog(&telemetry, positional[2], seed);
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    LoadSpriteTextures(true);
+    SetWorldRandomSeed(seed);
+
+    Entity entities[MAX_ENTITIES];
+    GameVariables game;
+    int dinoId = CreateWorld(entities, &game);
+    static unsigned char startSnapshot[MAX_WORLD_SNAPSHOT_SIZE];
+    int startSnapshotSize = SaveWorldSnapshot(entities, &game, startSnapshot, sizeof(startSnapshot));
+    // Every run, the first included, lays out its course from its seed the way the game does
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, seed);
+
+    int runs = 0;
+    int disagreeingRuns = 0;
+    long long runStartDisagreements = 0;
+    unsigned int runSeed = seed;
+    long long totalScore = 0;
+    int bestScore = 0;
+    //--------------------------------------------------------------------------------------
+
+    // Main loop
+    //--------------------------------------------------------------------------------------
+    double startTime = GetWallTime();
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        UpdateReflexBot(entities, &game, dinoId);
+        UpdateWorld(entities, &game);
+
+        SimEvent event;
+        while (telemetry.file != NULL && PopSimEvent(&event))
+        {
+            LogTelemetryEvent(&telemetry, &event);
+        }
+
+        if (dinoComponents[dinoId].isDead)
+        {
+            LogTelemetryRun(&telemetry, runSeed, &game);
+            runs++;
+            disagreeingRuns += collisionStats.disagreements > runStartDisagreements;
+            runStartDisagreements = collisionStats.disagreements;
+            totalScore += game.score;
+            if (game.score > bestScore)
+            {
+                bestScore = game.score;
+            }
+            runSeed = seed + runs;
+            RestartWorld(entities, &game, startSnapshot, startSnapshotSize, runSeed);
+        }
+    }
+    CloseTelemetryLog(&telemetry);
+    double elapsed = GetWallTime() - startTime;
+    //--------------------------------------------------------------------------------------
+
+    // Report
+    //--------------------------------------------------------------------------------------
+    printf("ticks %i\n", ticks);
+    printf("runs %i\n", runs);
+    printf("mean_score %.1f\n", runs > 0 ? (double)totalScore / runs : 0.0);
+    printf("best_score %i\n", bestScore);
+    printf("ns_per_tick %.1f\n", ticks > 0 ? elapsed * 1e9 / ticks : 0.0);
+    if (collisionMode == COLLISION_COMPARE)
+    {
+        // Every disagreement is a hit the boxes saw and the masks did not, and would have
+        // ended that run there
+        printf("narrow_tests %lld\n", collisionStats.tests);
+        printf("pixel_hits %lld\n", collisionStats.pixelHits);
+        printf("box_hits %lld\n", collisionStats.boxHits);
+        printf("disagreement_rate %.3f%%\n", collisionStats.tests > 0 ? 100.0 * collisionStats.disagreements / collisionStats.tests : 0.0);
+        printf("disagreeing_runs %i %.2f%%\n", disagreeingRuns, runs > 0 ? 100.0 * disagreeingRuns / runs : 0.0);
+    }
+
+    UnloadSpriteTextures(true);
+    //--------------------------------------------------------------------------------------
+
+    return 0;
+}
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,188 @@
+/*******************************************************************************************
+ *
+ *   Dino particles
+ *   Spawning, stepping and compacting the particle buffers. Built with AVX2 (for example
+ *   with -DDINO_NATIVE=ON on a machine that has it) the update runs eight particles at a
+ *   time; otherwise the plain loops are left to the compiler.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "particles.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+const float PARTICLE_GRAVITY = 0.15f;
+const float PARTICLE_FADE_TICKS = 12.0f;
+const float PARTICLE_TRAIL_SPEED = 3.0f;
+
+// How each kind of particle starts out: velocity and life are picked uniformly in range.
+typedef struct ParticleStyle
+{
+    float minVx, maxVx;
+    float minVy, maxVy;
+    float gravity;
+    float minLife, maxLife;
+    float minSize, maxSize;
+    Color color;
+} ParticleStyle;
+
+const ParticleStyle PARTICLE_STYLES[PARTICLE_KIND_COUNT] = {
+    [PARTICLE_DUST] = {-2.0f, -0.5f, -1.0f, 0.0f, 0.1f, 12.0f, 24.0f, 2.0f, 3.0f, (Color){83, 83, 83, 200}},
+    [PARTICLE_PUFF] = {-1.5f, 1.5f, -1.5f, -0.3f, 0.05f, 16.0f, 30.0f, 2.0f, 4.0f, (Color){160, 160, 160, 220}},
+    [PARTICLE_SPARK] = {-4.0f, 4.0f, -5.0f, 1.0f, 0.25f, 20.0f, 40.0f, 2.0f, 3.0f, (Color){83, 83, 83, 255}},
+    [PARTICLE_TRAIL] = {-6.0f, -3.0f, 0.0f, 0.0f, 0.0f, 8.0f, 14.0f, 1.0f, 2.0f, (Color){83, 83, 83, 120}},
+};
+//----------------------------------------------------------------------------------
+
+// Global Variables Definition
+//----------------------------------------------------------------------------------
+ParticleBuffer particles;
+
+// Particles are cosmetic, so they draw from their own generator and leave the world's alone.
+unsigned int particleRandomState = 0x2545f491;
+//----------------------------------------------------------------------------------
+
+// Local Functions Declaration
+//----------------------------------------------------------------------------------
+float GetParticleRandomFloat(float min, float max);
+void RemoveParticle(int i);
+//----------------------------------------------------------------------------------
+
+// Particle Functions Definition
+// ----------------------------------------------------------------------------------
+void SpawnParticles(int kind, float x, float y, int amount)
+{
+    const ParticleStyle *style = &PARTICLE_STYLES[kind];
+    for (int n = 0; n < amount && particles.count < MAX_PARTICLES; n++)
+    {
+        int i = particles.count++;
+        particles.x[i] = x;
+        particles.y[i] = y;
+        particles.vx[i] = GetParticleRandomFloat(style->minVx, style->maxVx);
+        particles.vy[i] = GetParticleRandomFloat(style->minVy, style->maxVy);
+        particles.gravity[i] = style->gravity;
+        particles.life[i] = GetParticleRandomFloat(style->minLife, style->maxLife);
+        particles.size[i] = GetParticleRandomFloat(style->minSize, style->maxSize);
+        particles.color[i] = style->color;
+    }
+}
+
+void SpawnSimEventParticles(const SimEvent *event)
+{
+    Rectangle sourceRec = spriteComponents[event->entity].sourceRec;
+    switch (event->type)
+    {
+    case SIM_EVENT_LAND:
+        SpawnParticles(PARTICLE_PUFF, event->x + sourceRec.width / 2, event->y + sourceRec.height, 24);
+        break;
+    case SIM_EVENT_DUCK:
+        SpawnParticles(PARTICLE_DUST, event->x, event->y + sourceRec.height, 12);
+        break;
+    case SIM_EVENT_HIT:
+        SpawnParticles(PARTICLE_SPARK, event->x + sourceRec.width, event->y + sourceRec.height / 2, 64);
+        break;
+    }
+}
+
+void SpawnSpeedTrail(GameVariables *game, int dinoId)
+{
+    float scrollMultiplier = ScalarToFloat(game->scrollMultiplier);
+    if (scrollMultiplier < PARTICLE_TRAIL_SPEED || dinoComponents[dinoId].isDead)
+        return;
+
+    Rectangle sourceRec = spriteComponents[dinoId].sourceRec;
+    int amount = 1 + (int)((scrollMultiplier - PARTICLE_TRAIL_SPEED) * 4.0f);
+    for (int n = 0; n < amount; n++)
+    {
+        SpawnParticles(PARTICLE_TRAIL,
+                       ScalarToFloat(positionComponents[dinoId].x),
+                       ScalarToFloat(positionComponents[dinoId].y) + GetParticleRandomFloat(0.0f, sourceRec.height),
+                       1);
+    }
+}
+
+void UpdateParticleSystem()
+{
+    // Step every particle, dead or alive. Lanes past count are scratch space inside the
+    // buffers, so whole vectors can be processed without a tail loop.
+    int count = particles.count;
+#if defined(__AVX2__)
+    const __m256 one = _mm256_set1_ps(1.0f);
+    for (int i = 0; i < count; i += 8)
+    {
+        __m256 vy = _mm256_add_ps(_mm256_loadu_ps(&particles.vy[i]), _mm256_loadu_ps(&particles.gravity[i]));
+        _mm256_storeu_ps(&particles.x[i], _mm256_add_ps(_mm256_loadu_ps(&particles.x[i]), _mm256_loadu_ps(&particles.vx[i])));
+        _mm256_storeu_ps(&particles.y[i], _mm256_add_ps(_mm256_loadu_ps(&particles.y[i]), vy));
+        _mm256_storeu_ps(&particles.vy[i], vy);
+        _mm256_storeu_ps(&particles.life[i], _mm256_sub_ps(_mm256_loadu_ps(&particles.life[i]), one));
+    }
+#else
+    for (int i = 0; i < count; i++)
+    {
+        particles.vy[i] += particles.gravity[i];
+        particles.x[i] += particles.vx[i];
+        particles.y[i] += particles.vy[i];
+        particles.life[i] -= 1.0f;
+    }
+#endif
+
+    // Compact from the back so whatever is swapped into a hole has already been checked.
+    // Blocks of eight with nothing dead in them are skipped with a single compare.
+    for (int block = (count - 1) & ~7; block >= 0; block -= 8)
+    {
+#if defined(__AVX2__)
+        __m256 isDead = _mm256_cmp_ps(_mm256_loadu_ps(&particles.life[block]), _mm256_setzero_ps(), _CMP_LE_OQ);
+        if (_mm256_movemask_ps(isDead) == 0)
+            continue;
+#endif
+        int last = block + 7 < particles.count - 1 ? block + 7 : particles.count - 1;
+        for (int i = last; i >= block; i--)
+        {
+            if (particles.life[i] <= 0.0f)
+            {
+                RemoveParticle(i);
+            }
+        }
+    }
+}
+
+void ClearParticles()
+{
+    particles.count = 0;
+}
+// ----------------------------------------------------------------------------------
+
+// Helper Functions Definition
+// ----------------------------------------------------------------------------------
+float GetParticleRandomFloat(float min, float max)
+{
+    particleRandomState ^= particleRandomState << 13;
+    particleRandomState ^= particleRandomState >> 17;
+    particleRandomState ^= particleRandomState << 5;
+    return min + (max - min) * (float)(particleRandomState >> 8) * (1.0f / 16777216.0f);
+}
+
+void RemoveParticle(int i)
+{
+    int last = --particles.count;
+    particles.x[i] = particles.x[last];
+    particles.y[i] = particles.y[last];
+    particles.vx[i] = particles.vx[last];
+    particles.vy[i] = particles.vy[last];
+    particles.gravity[i] = particles.gravity[last];
+    particles.life[i] = particles.life[last];
+    particles.size[i] = particles.size[last];
+    particles.color[i] = particles.color[last];
+}
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+/*******************************************************************************************
+ *
+ *   Dino particles
+ *   Short-lived dust, landing puffs, hit sparks and speed trails. They live outside the
+ *   ECS in structure-of-arrays buffers so tens of thousands can be stepped per tick, and
+ *   they never feed back into the simulation.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+// A multiple of the widest vector width so the update loop never needs a scalar tail
+#define MAX_PARTICLES 131072
+extern const float PARTICLE_GRAVITY;
+extern const float PARTICLE_FADE_TICKS;
+extern const float PARTICLE_TRAIL_SPEED;
+
+typedef enum ParticleKind
+{
+    PARTICLE_DUST,
+    PARTICLE_PUFF,
+    PARTICLE_SPARK,
+    PARTICLE_TRAIL,
+    PARTICLE_KIND_COUNT,
+} ParticleKind;
+//----------------------------------------------------------------------------------
+
+// Particle Buffers
+//----------------------------------------------------------------------------------
+// Live particles are packed into [0, count); a dead one is replaced by the last live one.
+// life is in ticks and counts down.
+typedef struct ParticleBuffer
+{
+    float x[MAX_PARTICLES];
+    float y[MAX_PARTICLES];
+    float vx[MAX_PARTICLES];
+    float vy[MAX_PARTICLES];
+    float gravity[MAX_PARTICLES];
+    float life[MAX_PARTICLES];
+    float size[MAX_PARTICLES];
+    Color color[MAX_PARTICLES];
+    int count;
+} ParticleBuffer;
+extern ParticleBuffer particles;
+//----------------------------------------------------------------------------------
+
+// Functions Declaration
+//----------------------------------------------------------------------------------
+void SpawnParticles(int kind, float x, float y, int amount);
+void SpawnSimEventParticles(const SimEvent *event);
+void SpawnSpeedTrail(GameVariables *game, int dinoId);
+void UpdateParticleSystem();
+void ClearParticles();
+//----------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,172 @@
+/*******************************************************************************************
+ *
+ *   Dino simulation pipeline
+ *   The worker thread and the hand-off between it and the main loop.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "pipeline.h"
+#include <time.h>
+//----------------------------------------------------------------------------------
+
+// Local Functions Declaration
+//----------------------------------------------------------------------------------
+void *RunSimulationThread(void *argument);
+void RunSimulationTick(SimulationThread *simulation);
+//----------------------------------------------------------------------------------
+
+// Pipeline Functions Definition
+// ----------------------------------------------------------------------------------
+// With isThreaded false the tick runs inline in StartSimulationTick, which is handy for
+// comparing frame times against the serial loop
+bool StartSimulationThread(SimulationThread *simulation, Entity *entities, GameVariables *game, bool isThreaded)
+{
+    *simulation = (SimulationThread){0};
+    simulation->entities = entities;
+    simulation->game = game;
+    simulation->isThreaded = isThreaded;
+    if (!isThreaded)
+        return true;
+
+    pthread_mutex_init(&simulation->mutex, NULL);
+    pthread_cond_init(&simulation->condition, NULL);
+    if (pthread_create(&simulation->thread, NULL, RunSimulationThread, simulation) != 0)
+    {
+        TraceLog(LOG_WARNING, "PIPELINE: Could not start the simulation thread, ticking on the main thread");
+        pthread_cond_destroy(&simulation->condition);
+        pthread_mutex_destroy(&simulation->mutex);
+        simulation->isThreaded = false;
+    }
+    return true;
+}
+
+void StopSimulationThread(SimulationThread *simulation)
+{
+    if (!simulation->isThreaded)
+        return;
+
+    pthread_mutex_lock(&simulation->mutex);
+    simulation->isStopping = true;
+    pthread_cond_broadcast(&simulation->condition);
+    pthread_mutex_unlock(&simulation->mutex);
+    pthread_join(simulation->thread, NULL);
+
+    pthread_cond_destroy(&simulation->condition);
+    pthread_mutex_destroy(&simulation->mutex);
+    simulation->isThreaded = false;
+}
+
+// Hands the world to the worker for one tick. Input for the tick has to be queued first.
+void StartSimulationTick(SimulationThread *simulation)
+{
+    if (!simulation->isThreaded)
+    {
+        RunSimulationTick(simulation);
+        simulation->isTickRequested = true;
+        return;
+    }
+
+    pthread_mutex_lock(&simulation->mutex);
+    simulation->isTickRequested = true;
+    simulation->isTickRunning = true;
+    pthread_cond_broadcast(&simulation->condition);
+    pthread_mutex_unlock(&simulation->mutex);
+}
+
+// Blocks until the tick started last is done and takes the world back. Returns whether
+// there was a tick to wait for.
+bool WaitForSimulationTick(SimulationThread *simulation)
+{
+    if (!simulation->isThreaded)
+    {
+        bool wasTickRequested = simulation->isTickRequested;
+        simulation->isTickRequested = false;
+        return wasTickRequested;
+    }
+
+    pthread_mutex_lock(&simulation->mutex);
+    while (simulation->isTickRunning)
+    {
+        pthread_cond_wait(&simulation->condition, &simulation->mutex);
+    }
+    bool wasTickRequested = simulation->isTickRequested;
+    simulation->isTickRequested = false;
+    pthread_mutex_unlock(&simulation->mutex);
+    return wasTickRequested;
+}
+
+void UpdateFrameTime(double *averageMs, double seconds)
+{
+    *averageMs += (seconds * 1000.0 - *averageMs) * 0.05;
+}
+
+// Call once a frame, before EndDrawing. While idle, EndDrawing blocks until the next input
+// event instead of presenting at the target rate; raylib has no timeout for that wait, so
+// anything still animating has to keep isIdle false until it has settled.
+void UpdateIdleState(IdleStats *idle, bool isIdle)
+{
+    if (isIdle == idle->isIdle)
+    {
+        idle->frames += isIdle;
+        return;
+    }
+
+    double now = GetWallTime();
+    clock_t cpuClock = clock();
+    if (isIdle)
+    {
+        EnableEventWaiting();
+        idle->startSeconds = now;
+        idle->startClock = cpuClock;
+        idle->frames++;
+    }
+    else
+    {
+        DisableEventWaiting();
+        idle->wallSeconds += now - idle->startSeconds;
+        idle->cpuSeconds += (double)(cpuClock - idle->startClock) / CLOCKS_PER_SEC;
+    }
+    idle->isIdle = isIdle;
+}
+// ----------------------------------------------------------------------------------
+
+// Worker Functions Definition
+// ----------------------------------------------------------------------------------
+void *RunSimulationThread(void *argument)
+{
+    SimulationThread *simulation = argument;
+    pthread_mutex_lock(&simulation->mutex);
+    while (!simulation->isStopping)
+    {
+        if (!simulation->isTickRunning)
+        {
+            pthread_cond_wait(&simulation->condition, &simulation->mutex);
+            continue;
+        }
+
+        pthread_mutex_unlock(&simulation->mutex);
+        RunSimulationTick(simulation);
+        pthread_mutex_lock(&simulation->mutex);
+
+        simulation->isTickRunning = false;
+        pthread_cond_broadcast(&simulation->condition);
+    }
+    pthread_mutex_unlock(&simulation->mutex);
+    return NULL;
+}
+
+void RunSimulationTick(SimulationThread *simulation)
+{
+    double startTime = GetWallTime();
+    PushRewindSnapshot(simulation->entities, simulation->game);
+    UpdateWorld(simulation->entities, simulation->game);
+    simulation->lastTickSeconds = GetWallTime() - startTime;
+}
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,76 @@
+/*******************************************************************************************
+ *
+ *   Dino simulation pipeline
+ *   Runs the next simulation tick on a worker thread while the main thread draws the
+ *   previous one from its own copy. The world belongs to the worker from
+ *   StartSimulationTick until WaitForSimulationTick returns, and to the main thread the
+ *   rest of the time, so nothing else needs to be locked.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+#include <pthread.h>
+#include <time.h>
+//----------------------------------------------------------------------------------
+
+// Pipeline Types
+//----------------------------------------------------------------------------------
+// Where each frame goes, in milliseconds, smoothed over the last second or so. sim runs on
+// the worker at the same time as draw and present; wait is how long the main thread still
+// had to block for it.
+typedef struct FrameTimes
+{
+    double simMs;
+    double waitMs;
+    double syncMs;
+    double drawMs;
+    double presentMs;
+} FrameTimes;
+
+// Time spent sleeping on input in MENU and GAMEOVER, and the CPU the process used meanwhile
+typedef struct IdleStats
+{
+    bool isIdle;
+    double startSeconds;
+    clock_t startClock;
+    double wallSeconds;
+    double cpuSeconds;
+    int frames;
+} IdleStats;
+
+typedef struct SimulationThread
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    Entity *entities;
+    GameVariables *game;
+    bool isThreaded;
+    bool isTickRequested;
+    bool isTickRunning;
+    bool isStopping;
+    double lastTickSeconds;
+} SimulationThread;
+//----------------------------------------------------------------------------------
+
+// Functions Declaration
+//----------------------------------------------------------------------------------
+bool StartSimulationThread(SimulationThread *simulation, Entity *entities, GameVariables *game, bool isThreaded);
+void StopSimulationThread(SimulationThread *simulation);
+void StartSimulationTick(SimulationThread *simulation);
+bool WaitForSimulationTick(SimulationThread *simulation);
+void UpdateFrameTime(double *averageMs, double seconds);
+void UpdateIdleState(IdleStats *idle, bool isIdle);
+//----------------------------------------------------------------------------------
+
+#endif
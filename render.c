@@ -0,0 +1,209 @@
+/*******************************************************************************************
+ *
+ *   Dino render commands
+ *   Culling against the view, the radix sort on the packed keys and submission.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "render.h"
+#include <string.h>
+//----------------------------------------------------------------------------------
+
+// Render Command Functions Definition
+// ----------------------------------------------------------------------------------
+void CaptureRenderState(Entity *entities, GameVariables *game, int dinoId, RenderState *state)
+{
+    BuildRenderCommands(entities, &state->sprites);
+    state->scrollIndex = game->scrollIndex;
+    state->score = game->score;
+    state->isDinoDead = dinoComponents[dinoId].isDead;
+    state->isDinoAirborne = positionComponents[dinoId].y < ToScalar(FLOOR_Y_POS);
+}
+
+void BuildRenderCommands(Entity *entities, RenderCommandList *list)
+{
+    list->count = 0;
+    list->culled = 0;
+    // Higher entity ids have always been drawn first. The sort is stable, so building the
+    // list in that order keeps it among sprites with the same key.
+    for (int i = nextEntityId - 1; i >= 0; i--)
+    {
+        if (!HasComponent(entities, i, SPRITE))
+            continue;
+        if (!HasComponent(entities, i, POSITION))
+            continue;
+
+        Vector2 position = {ScalarToFloat(positionComponents[i].x), ScalarToFloat(positionComponents[i].y)};
+        Rectangle sourceRec = spriteComponents[i].sourceRec;
+        if (position.x >= WIDTH || position.y >= HEIGHT ||
+            position.x + sourceRec.width <= 0 || position.y + sourceRec.height <= 0)
+        {
+            list->culled++;
+            continue;
+        }
+
+        Texture2D texture = spriteComponents[i].texture;
+        list->commands[list->count++] = (RenderCommand){
+            GetRenderSortKey(GetRenderLayer(entities, i), texture.id), texture, sourceRec, position};
+    }
+}
+
+// Least significant digit first, a byte at a time, which keeps commands with equal keys in
+// the order they were built. All eight histograms come from one pass over the keys, and
+// bytes that are the same in every key (most of the texture id and the top three, usually)
+// are skipped.
+void SortRenderCommands(RenderCommandList *list)
+{
+    static RenderCommand scratch[MAX_RENDER_COMMANDS];
+    RenderCommand *source = list->commands;
+    RenderCommand *target = scratch;
+    if (list->count < 2)
+        return;
+
+    int counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < list->count; i++)
+    {
+        for (int pass = 0; pass < 8; pass++)
+        {
+            counts[pass][(source[i].key >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    for (int pass = 0; pass < 8; pass++)
+    {
+        int shift = pass * 8;
+        if (counts[pass][(source[0].key >> shift) & 0xff] == list->count)
+            continue;
+
+        int offsets[256];
+        int offset = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            offsets[digit] = offset;
+            offset += counts[pass][digit];
+        }
+        for (int i = 0; i < list->count; i++)
+        {
+            target[offsets[(source[i].key >> shift) & 0xff]++] = source[i];
+        }
+
+        RenderCommand *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != list->commands)
+    {
+        memcpy(list->commands, source, list->count * sizeof(RenderCommand));
+    }
+}
+
+void SubmitRenderCommands(const RenderCommandList *list)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        const RenderCommand *command = &list->commands[i];
+        DrawTextureRec(command->texture, command->sourceRec, command->position, WHITE);
+    }
+}
+// ----------------------------------------------------------------------------------
+
+// Render Target Functions Definition
+// ----------------------------------------------------------------------------------
+// divisor 2 draws the 1280x600 world at 640x300, where the 2x sprites land on their own
+// pixel grid. The divisor has to split both sides evenly (2, 4, 5, 8, 10, 20 or 40) so one
+// zoom fits both axes; any other draws at full size. Call after InitWindow, which has to be
+// given FLAG_WINDOW_RESIZABLE for the window to be resized.
+void LoadRenderTarget(RenderTarget *target, int divisor)
+{
+    *target = (RenderTarget){0};
+    if (divisor < 1 || WIDTH % divisor != 0 || HEIGHT % divisor != 0)
+    {
+        TraceLog(LOG_WARNING, "RENDER: %i does not divide %ix%i evenly, drawing at full size", divisor, WIDTH, HEIGHT);
+        return;
+    }
+    target->width = WIDTH / divisor;
+    target->height = HEIGHT / divisor;
+    target->texture = LoadRenderTexture(target->width, target->height);
+    if (target->texture.id == 0)
+    {
+        TraceLog(LOG_WARNING, "RENDER: Could not create a %ix%i target, drawing at full size", target->width, target->height);
+        return;
+    }
+    SetTextureFilter(target->texture.texture, TEXTURE_FILTER_POINT);
+    target->isEnabled = true;
+}
+
+void UnloadRenderTarget(RenderTarget *target)
+{
+    if (target->isEnabled)
+    {
+        UnloadRenderTexture(target->texture);
+    }
+    *target = (RenderTarget){0};
+}
+
+// Everything drawn until EndRenderTarget is in world coordinates either way
+void BeginRenderTarget(RenderTarget *target)
+{
+    if (!target->isEnabled)
+        return;
+    BeginTextureMode(target->texture);
+    BeginMode2D((Camera2D){.zoom = (float)target->width / WIDTH});
+}
+
+// Upscales the target by the largest whole factor that fits the window, centred with
+// black bars, and maps the mouse back to world coordinates so hit tests need not know.
+// Call between BeginDrawing and EndDrawing; whatever is drawn after it is in window pixels.
+void EndRenderTarget(RenderTarget *target)
+{
+    if (!target->isEnabled)
+        return;
+    EndMode2D();
+    EndTextureMode();
+
+    int screenWidth = GetScreenWidth();
+    int screenHeight = GetScreenHeight();
+    float scaleX = (float)screenWidth / target->width;
+    float scaleY = (float)screenHeight / target->height;
+    float scale = scaleX < scaleY ? scaleX : scaleY;
+    // A window smaller than the target still shows all of it, just not pixel perfect
+    scale = scale >= 1.0f ? floorf(scale) : scale;
+    float width = target->width * scale;
+    float height = target->height * scale;
+    target->destination = (Rectangle){floorf((screenWidth - width) * 0.5f), floorf((screenHeight - height) * 0.5f), width, height};
+
+    ClearBackground(BLACK);
+    // Render textures are stored upside down
+    Rectangle source = {0.0f, 0.0f, (float)target->width, (float)-target->height};
+    DrawTexturePro(target->texture.texture, source, target->destination, (Vector2){0.0f, 0.0f}, 0.0f, WHITE);
+
+    SetMouseOffset((int)-target->destination.x, (int)-target->destination.y);
+    SetMouseScale((float)WIDTH / width, (float)HEIGHT / height);
+}
+// ----------------------------------------------------------------------------------
+
+// Helper Functions Definition
+// ----------------------------------------------------------------------------------
+uint64_t GetRenderSortKey(int layer, unsigned int textureId)
+{
+    return ((uint64_t)(layer & 0xff) << 32) | (uint64_t)textureId;
+}
+
+int GetRenderLayer(Entity *entities, int i)
+{
+    if (HasComponent(entities, i, DINO))
+        return RENDER_LAYER_DINO;
+    if (HasComponent(entities, i, CLOUD))
+        return RENDER_LAYER_SKY;
+    return RENDER_LAYER_GROUND;
+}
+// ----------------------------------------------------------------------------------
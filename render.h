@@ -0,0 +1,98 @@
+/*******************************************************************************************
+ *
+ *   Dino render commands
+ *   The sprite pass is split in three: build a command per visible sprite, sort the
+ *   commands by a packed key, then submit them in one go. Sprites parked off-screen never
+ *   reach raylib, and sprites in a layer that share a texture are drawn back to back.
+ *
+ *   The scene can also be drawn into a smaller offscreen target, in world coordinates
+ *   through a zoomed camera, and blown up to the window by a whole number of pixels.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+#ifndef RENDER_H
+#define RENDER_H
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+#define MAX_RENDER_COMMANDS MAX_ENTITIES
+
+// Back to front. The layer is the most significant part of the sort key.
+typedef enum RenderLayer
+{
+    RENDER_LAYER_SKY,
+    RENDER_LAYER_GROUND,
+    RENDER_LAYER_DINO,
+} RenderLayer;
+//----------------------------------------------------------------------------------
+
+// Render Commands
+//----------------------------------------------------------------------------------
+// Sort key, most significant first: layer (8 bits), texture id (32 bits). Every sprite in a
+// layer shares its depth, so the texture id groups them into runs that raylib batches, and
+// sprites with the same texture keep the order they were built in. Obstacles of different
+// kinds that overlap draw in texture order; obstacle ids are recycled, so the id order they
+// used to follow meant nothing either.
+typedef struct RenderCommand
+{
+    uint64_t key;
+    Texture2D texture;
+    Rectangle sourceRec;
+    Vector2 position;
+} RenderCommand;
+
+typedef struct RenderCommandList
+{
+    RenderCommand commands[MAX_RENDER_COMMANDS];
+    int count;
+    int culled;
+} RenderCommandList;
+
+// Everything a frame is drawn from, copied out of the world so the next tick can run
+// while it is drawn.
+typedef struct RenderState
+{
+    RenderCommandList sprites;
+    Scalar scrollIndex;
+    int score;
+    bool isDinoDead;
+    bool isDinoAirborne;
+} RenderState;
+
+// The offscreen target is width x height; the window shows it scaled into destination.
+// Without a target the scene is drawn straight to the window, which stays WIDTH x HEIGHT.
+typedef struct RenderTarget
+{
+    bool isEnabled;
+    RenderTexture2D texture;
+    int width;
+    int height;
+    Rectangle destination;
+} RenderTarget;
+//----------------------------------------------------------------------------------
+
+// Functions Declaration
+//----------------------------------------------------------------------------------
+void CaptureRenderState(Entity *entities, GameVariables *game, int dinoId, RenderState *state);
+void BuildRenderCommands(Entity *entities, RenderCommandList *list);
+void SortRenderCommands(RenderCommandList *list);
+void SubmitRenderCommands(const RenderCommandList *list);
+uint64_t GetRenderSortKey(int layer, unsigned int textureId);
+int GetRenderLayer(Entity *entities, int i);
+void LoadRenderTarget(RenderTarget *target, int divisor);
+void UnloadRenderTarget(RenderTarget *target);
+void BeginRenderTarget(RenderTarget *target);
+void EndRenderTarget(RenderTarget *target);
+//----------------------------------------------------------------------------------
+
+#endif
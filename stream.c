@@ -0,0 +1,555 @@
+/*******************************************************************************************
+ *
+ *   Dino spectator stream
+ *   See stream.h. Uses POSIX sockets.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+//----------------------------------------------------------------------------------
+
+// Local Variables Definition
+//----------------------------------------------------------------------------------
+const int STREAM_DEFAULT_PORT = 7777;
+const int STREAM_KEYFRAME_INTERVAL = 300;
+const int STREAM_REPORT_INTERVAL = 600;
+const float STREAM_POSITION_SCALE = 4.0f;
+//----------------------------------------------------------------------------------
+
+// Stream Functions Definition
+// ----------------------------------------------------------------------------------
+bool StartStreamServer(StreamServer *server, int port)
+{
+    // Spectators that vanish mid-send must not take the game down with them
+    signal(SIGPIPE, SIG_IGN);
+
+    server->listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listenSocket < 0)
+    {
+        TraceLog(LOG_WARNING, "STREAM: Failed to create socket");
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(server->listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((unsigned short)port);
+    if (bind(server->listenSocket, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        listen(server->listenSocket, MAX_SPECTATORS) < 0)
+    {
+        TraceLog(LOG_WARNING, "STREAM: Failed to listen on port %i", port);
+        close(server->listenSocket);
+        return false;
+    }
+    fcntl(server->listenSocket, F_SETFL, fcntl(server->listenSocket, F_GETFL, 0) | O_NONBLOCK);
+    TraceLog(LOG_INFO, "STREAM: Serving spectators on port %i", port);
+    return true;
+}
+
+void StopStreamServer(StreamServer *server)
+{
+    while (server->spectatorCount > 0)
+    {
+        RemoveSpectator(server, server->spectatorCount - 1);
+    }
+    close(server->listenSocket);
+    if (server->messagesSent > 0)
+    {
+        TraceLog(LOG_INFO, "STREAM: %i messages, %.1f bytes/tick per spectator, %i keyframes",
+                 server->messagesSent, (double)server->bytesSent / server->messagesSent, server->keyframesSent);
+    }
+}
+
+void AcceptSpectators(StreamServer *server)
+{
+    while (server->spectatorCount < MAX_SPECTATORS)
+    {
+        int clientSocket = accept(server->listenSocket, NULL, NULL);
+        if (clientSocket < 0)
+            return;
+        int noDelay = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK);
+        server->spectators[server->spectatorCount++] = (Spectator){clientSocket, false, 0, 0, {0}, 0};
+        TraceLog(LOG_INFO, "STREAM: Spectator connected (%i watching)", server->spectatorCount);
+    }
+}
+
+void ReadSpectatorAcks(StreamServer *server)
+{
+    for (int i = server->spectatorCount - 1; i >= 0; i--)
+    {
+        Spectator *spectator = &server->spectators[i];
+        while (true)
+        {
+            ssize_t received = recv(spectator->socket, spectator->ackBuffer + spectator->ackBytes, 4 - spectator->ackBytes, 0);
+            if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            {
+                RemoveSpectator(server, i);
+                break;
+            }
+            if (received < 0)
+                break;
+            spectator->ackBytes += (int)received;
+            if (spectator->ackBytes < 4)
+                continue;
+            unsigned int ack = (unsigned int)spectator->ackBuffer[0] | (unsigned int)spectator->ackBuffer[1] << 8 |
+                               (unsigned int)spectator->ackBuffer[2] << 16 | (unsigned int)spectator->ackBuffer[3] << 24;
+            spectator->ackBytes = 0;
+            // An ack of all ones means the spectator lost its baseline and needs a keyframe
+            spectator->hasAck = ack != 0xffffffff;
+            spectator->ackedTick = ack;
+        }
+    }
+}
+
+void RemoveSpectator(StreamServer *server, int index)
+{
+    close(server->spectators[index].socket);
+    server->spectators[index] = server->spectators[--server->spectatorCount];
+    TraceLog(LOG_INFO, "STREAM: Spectator disconnected (%i watching)", server->spectatorCount);
+}
+
+void PublishStreamFrame(StreamServer *server, StreamFrame *frame)
+{
+    static unsigned char message[STREAM_BUFFER_SIZE];
+
+    frame->tick = server->tick++;
+    server->history[frame->tick % STREAM_HISTORY] = *frame;
+    AcceptSpectators(server);
+    ReadSpectatorAcks(server);
+
+    for (int i = server->spectatorCount - 1; i >= 0; i--)
+    {
+        Spectator *spectator = &server->spectators[i];
+        StreamFrame *base = NULL;
+        unsigned int baseDistance = frame->tick - spectator->ackedTick;
+        if (spectator->hasAck &&
+            baseDistance > 0 && baseDistance < STREAM_HISTORY &&
+            server->history[spectator->ackedTick % STREAM_HISTORY].tick == spectator->ackedTick &&
+            frame->tick - spectator->keyframeTick < (unsigned int)STREAM_KEYFRAME_INTERVAL)
+        {
+            base = &server->history[spectator->ackedTick % STREAM_HISTORY];
+        }
+        if (base == NULL)
+        {
+            baseDistance = 0;
+            spectator->keyframeTick = frame->tick;
+            server->keyframesSent++;
+        }
+
+        int size = EncodeStreamFrame(frame, base, baseDistance, message);
+        // A spectator that cannot take a whole message right now is too far behind to keep
+        if (send(spectator->socket, message, size, 0) != size)
+        {
+            RemoveSpectator(server, i);
+            continue;
+        }
+        server->bytesSent += size;
+        server->messagesSent++;
+    }
+
+    if (frame->tick % STREAM_REPORT_INTERVAL == 0 && server->messagesSent > 0)
+    {
+        TraceLog(LOG_INFO, "STREAM: %i watching, %.1f bytes/tick per spectator, %i keyframes",
+                 server->spectatorCount, (double)server->bytesSent / server->messagesSent, server->keyframesSent);
+    }
+}
+
+bool ConnectStreamClient(StreamClient *client, const char *host, int port)
+{
+    client->socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (client->socket < 0)
+        return false;
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1 ||
+        connect(client->socket, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        TraceLog(LOG_WARNING, "STREAM: Failed to connect to %s:%i", host, port);
+        close(client->socket);
+        return false;
+    }
+    int noDelay = 1;
+    setsockopt(client->socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    fcntl(client->socket, F_SETFL, fcntl(client->socket, F_GETFL, 0) | O_NONBLOCK);
+    TraceLog(LOG_INFO, "STREAM: Spectating %s:%i", host, port);
+    return true;
+}
+
+void DisconnectStreamClient(StreamClient *client)
+{
+    if (client->socket >= 0)
+    {
+        close(client->socket);
+    }
+    if (client->framesReceived > 0)
+    {
+        TraceLog(LOG_INFO, "STREAM: %i frames, %.1f bytes/tick received",
+                 client->framesReceived, (double)client->bytesReceived / client->framesReceived);
+    }
+}
+
+// Returns whether at least one frame arrived; frame is the latest. A connection that sends
+// something that cannot be a message, or that the server closes, is dropped and the socket
+// left at -1; nothing arrives after that.
+bool ReceiveStreamFrame(StreamClient *client, StreamFrame *frame)
+{
+    if (client->socket < 0)
+        return false;
+
+    // A full buffer always holds a whole message, so there is room again after decoding
+    const char *dropReason = NULL;
+    while (client->bufferCount < STREAM_BUFFER_SIZE)
+    {
+        ssize_t received = recv(client->socket, client->buffer + client->bufferCount, STREAM_BUFFER_SIZE - client->bufferCount, 0);
+        if (received > 0)
+        {
+            client->bufferCount += (int)received;
+            client->bytesReceived += received;
+            continue;
+        }
+        if (received == 0)
+        {
+            dropReason = "Server closed the connection";
+        }
+        else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            dropReason = "Could not read from the server";
+        }
+        break;
+    }
+
+    bool hasFrame = false;
+    int offset = 0;
+    while (client->bufferCount - offset >= 4)
+    {
+        const unsigned char *data = client->buffer + offset;
+        unsigned int length = (unsigned int)data[0] | (unsigned int)data[1] << 8 | (unsigned int)data[2] << 16 | (unsigned int)data[3] << 24;
+        if (length > STREAM_BUFFER_SIZE - 4)
+        {
+            DropStreamConnection(client, "Message length out of range");
+            return hasFrame;
+        }
+        int size = (int)length;
+        if (client->bufferCount - offset - 4 < size)
+            break;
+
+        unsigned int ack = 0xffffffff;
+        if (DecodeStreamFrame(data + 4, size, client->history, frame))
+        {
+            client->history[frame->tick % STREAM_HISTORY] = *frame;
+            client->framesReceived++;
+            ack = frame->tick;
+            hasFrame = true;
+        }
+        if (!SendStreamAck(client, ack))
+            return hasFrame;
+        offset += 4 + size;
+    }
+    memmove(client->buffer, client->buffer + offset, client->bufferCount - offset);
+    client->bufferCount -= offset;
+    // Whatever arrived before the close is still shown
+    if (dropReason != NULL && client->socket >= 0)
+    {
+        DropStreamConnection(client, dropReason);
+    }
+    return hasFrame;
+}
+
+// Acks are 4 bytes each and the server reads them 4 at a time, so whatever part of one the
+// socket does not take is kept and sent first next time
+bool SendStreamAck(StreamClient *client, unsigned int ack)
+{
+    if (client->ackBytes + 4 > (int)sizeof(client->ackBuffer))
+    {
+        DropStreamConnection(client, "Server stopped reading acks");
+        return false;
+    }
+    unsigned char *ackData = client->ackBuffer + client->ackBytes;
+    ackData[0] = ack & 0xff;
+    ackData[1] = (ack >> 8) & 0xff;
+    ackData[2] = (ack >> 16) & 0xff;
+    ackData[3] = (ack >> 24) & 0xff;
+    client->ackBytes += 4;
+
+    ssize_t sent = send(client->socket, client->ackBuffer, client->ackBytes, 0);
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        DropStreamConnection(client, "Could not send acks");
+        return false;
+    }
+    if (sent > 0)
+    {
+        memmove(client->ackBuffer, client->ackBuffer + sent, client->ackBytes - sent);
+        client->ackBytes -= (int)sent;
+    }
+    return true;
+}
+
+void DropStreamConnection(StreamClient *client, const char *reason)
+{
+    TraceLog(LOG_WARNING, "STREAM: %s, dropping the connection", reason);
+    close(client->socket);
+    client->socket = -1;
+    client->bufferCount = 0;
+    client->ackBytes = 0;
+}
+
+void CaptureStreamFrame(Entity *entities, GameVariables *game, int gameState, int highScore, StreamFrame *frame)
+{
+    memset(frame, 0, sizeof(StreamFrame));
+    frame->gameState = gameState;
+    frame->score = game->score;
+    frame->highScore = highScore;
+    frame->scrollIndex = (int)lroundf(ScalarToFloat(game->scrollIndex) * STREAM_POSITION_SCALE);
+    frame->spriteCount = nextEntityId;
+    for (int i = 0; i < nextEntityId; i++)
+    {
+        if (!HasComponent(entities, i, SPRITE))
+            continue;
+        if (!HasComponent(entities, i, POSITION))
+            continue;
+        int texture = GetSpriteTextureIndex(spriteComponents[i].texture);
+        if (texture < 0)
+            continue;
+        frame->sprites[i] = (StreamSprite){
+            true,
+            texture,
+            (int)lroundf(ScalarToFloat(positionComponents[i].x) * STREAM_POSITION_SCALE),
+            (int)lroundf(ScalarToFloat(positionComponents[i].y) * STREAM_POSITION_SCALE),
+            (int)spriteComponents[i].sourceRec.x,
+            (int)spriteComponents[i].sourceRec.y,
+            (int)spriteComponents[i].sourceRec.width,
+            (int)spriteComponents[i].sourceRec.height};
+    }
+}
+
+void ApplyStreamFrame(Entity *entities, GameVariables *game, int *highScore, StreamFrame *frame)
+{
+    game->score = frame->score;
+    game->scrollIndex = ToScalar(frame->scrollIndex / STREAM_POSITION_SCALE);
+    *highScore = frame->highScore;
+    nextEntityId = frame->spriteCount;
+    for (int i = 0; i < frame->spriteCount; i++)
+    {
+        StreamSprite *sprite = &frame->sprites[i];
+        entities[i] = (Entity){i, sprite->isVisible ? SPRITE | POSITION : 0};
+        if (!sprite->isVisible)
+            continue;
+        positionComponents[i] = (PositionComponent){ToScalar(sprite->x / STREAM_POSITION_SCALE), ToScalar(sprite->y / STREAM_POSITION_SCALE)};
+        spriteComponents[i] = (SpriteComponent){
+            spriteTextures[sprite->texture],
+            (Rectangle){(float)sprite->sourceX, (float)sprite->sourceY, (float)sprite->sourceWidth, (float)sprite->sourceHeight}};
+    }
+}
+
+int EncodeStreamFrame(StreamFrame *frame, StreamFrame *base, unsigned int baseDistance, unsigned char *data)
+{
+    static StreamFrame emptyFrame;
+    if (base == NULL)
+    {
+        base = &emptyFrame;
+    }
+
+    unsigned char *cursor = data + 4;
+    WriteVarint(&cursor, frame->tick);
+    WriteVarint(&cursor, baseDistance);
+    *cursor++ = (unsigned char)frame->spriteCount;
+
+    unsigned char hudChanges = 0;
+    hudChanges |= frame->gameState != base->gameState ? STREAM_HUD_STATE : 0;
+    hudChanges |= frame->score != base->score ? STREAM_HUD_SCORE : 0;
+    hudChanges |= frame->highScore != base->highScore ? STREAM_HUD_HIGHSCORE : 0;
+    hudChanges |= frame->scrollIndex != base->scrollIndex ? STREAM_HUD_SCROLL : 0;
+    *cursor++ = hudChanges;
+    if (hudChanges & STREAM_HUD_STATE)
+        *cursor++ = (unsigned char)frame->gameState;
+    if (hudChanges & STREAM_HUD_SCORE)
+        WriteVarint(&cursor, ZigZagEncode(frame->score - base->score));
+    if (hudChanges & STREAM_HUD_HIGHSCORE)
+        WriteVarint(&cursor, ZigZagEncode(frame->highScore - base->highScore));
+    if (hudChanges & STREAM_HUD_SCROLL)
+        WriteVarint(&cursor, ZigZagEncode(frame->scrollIndex - base->scrollIndex));
+
+    // One bit per sprite slot, followed by the changed fields of each flagged slot
+    unsigned char *changedSlots = cursor;
+    int changedSlotBytes = (frame->spriteCount + 7) / 8;
+    memset(changedSlots, 0, changedSlotBytes);
+    cursor += changedSlotBytes;
+    for (int i = 0; i < frame->spriteCount; i++)
+    {
+        StreamSprite *sprite = &frame->sprites[i];
+        StreamSprite *baseSprite = &base->sprites[i];
+        unsigned char changes = 0;
+        changes |= (sprite->isVisible != baseSprite->isVisible || sprite->texture != baseSprite->texture) ? STREAM_SPRITE_TEXTURE : 0;
+        changes |= sprite->x != baseSprite->x ? STREAM_SPRITE_X : 0;
+        changes |= sprite->y != baseSprite->y ? STREAM_SPRITE_Y : 0;
+        changes |= (sprite->sourceX != baseSprite->sourceX || sprite->sourceY != baseSprite->sourceY ||
+                    sprite->sourceWidth != baseSprite->sourceWidth || sprite->sourceHeight != baseSprite->sourceHeight)
+                       ? STREAM_SPRITE_SOURCE
+                       : 0;
+        if (changes == 0)
+            continue;
+
+        changedSlots[i / 8] |= 1 << (i % 8);
+        *cursor++ = changes;
+        if (changes & STREAM_SPRITE_TEXTURE)
+            *cursor++ = sprite->isVisible ? (unsigned char)sprite->texture : 0xff;
+        if (changes & STREAM_SPRITE_X)
+            WriteVarint(&cursor, ZigZagEncode(sprite->x - baseSprite->x));
+        if (changes & STREAM_SPRITE_Y)
+            WriteVarint(&cursor, ZigZagEncode(sprite->y - baseSprite->y));
+        if (changes & STREAM_SPRITE_SOURCE)
+        {
+            WriteVarint(&cursor, ZigZagEncode(sprite->sourceX - baseSprite->sourceX));
+            WriteVarint(&cursor, ZigZagEncode(sprite->sourceY - baseSprite->sourceY));
+            WriteVarint(&cursor, ZigZagEncode(sprite->sourceWidth - baseSprite->sourceWidth));
+            WriteVarint(&cursor, ZigZagEncode(sprite->sourceHeight - baseSprite->sourceHeight));
+        }
+    }
+
+    unsigned int size = (unsigned int)(cursor - data - 4);
+    data[0] = size & 0xff;
+    data[1] = (size >> 8) & 0xff;
+    data[2] = (size >> 16) & 0xff;
+    data[3] = (size >> 24) & 0xff;
+    return (int)(cursor - data);
+}
+
+bool DecodeStreamFrame(const unsigned char *data, int size, StreamFrame *history, StreamFrame *frame)
+{
+    static StreamFrame emptyFrame;
+    const unsigned char *cursor = data;
+    const unsigned char *end = data + size;
+    unsigned int tick, baseDistance, value;
+    if (!ReadVarint(&cursor, end, &tick) || !ReadVarint(&cursor, end, &baseDistance) || end - cursor < 2)
+        return false;
+
+    StreamFrame *base = &emptyFrame;
+    if (baseDistance != 0)
+    {
+        base = &history[(tick - baseDistance) % STREAM_HISTORY];
+        if (base->tick != tick - baseDistance)
+            return false;
+    }
+
+    StreamFrame decoded = *base;
+    decoded.tick = tick;
+    decoded.spriteCount = *cursor++;
+    if (decoded.spriteCount > MAX_ENTITIES)
+        return false;
+    for (int i = base->spriteCount; i < decoded.spriteCount; i++)
+    {
+        decoded.sprites[i] = (StreamSprite){0};
+    }
+
+    unsigned char hudChanges = *cursor++;
+    if (hudChanges & STREAM_HUD_STATE)
+    {
+        if (cursor >= end)
+            return false;
+        decoded.gameState = *cursor++;
+    }
+    if ((hudChanges & STREAM_HUD_SCORE) && !ReadVarint(&cursor, end, &value))
+        return false;
+    decoded.score += (hudChanges & STREAM_HUD_SCORE) ? ZigZagDecode(value) : 0;
+    if ((hudChanges & STREAM_HUD_HIGHSCORE) && !ReadVarint(&cursor, end, &value))
+        return false;
+    decoded.highScore += (hudChanges & STREAM_HUD_HIGHSCORE) ? ZigZagDecode(value) : 0;
+    if ((hudChanges & STREAM_HUD_SCROLL) && !ReadVarint(&cursor, end, &value))
+        return false;
+    decoded.scrollIndex += (hudChanges & STREAM_HUD_SCROLL) ? ZigZagDecode(value) : 0;
+
+    const unsigned char *changedSlots = cursor;
+    cursor += (decoded.spriteCount + 7) / 8;
+    if (cursor > end)
+        return false;
+    for (int i = 0; i < decoded.spriteCount; i++)
+    {
+        if (!(changedSlots[i / 8] & (1 << (i % 8))))
+            continue;
+        StreamSprite *sprite = &decoded.sprites[i];
+        if (cursor >= end)
+            return false;
+        unsigned char changes = *cursor++;
+        if (changes & STREAM_SPRITE_TEXTURE)
+        {
+            if (cursor >= end)
+                return false;
+            unsigned char texture = *cursor++;
+            sprite->isVisible = texture < SPRITE_TEXTURE_COUNT;
+            sprite->texture = sprite->isVisible ? texture : 0;
+        }
+        int *fields[6] = {&sprite->x, &sprite->y, &sprite->sourceX, &sprite->sourceY, &sprite->sourceWidth, &sprite->sourceHeight};
+        bool hasField[6] = {changes & STREAM_SPRITE_X, changes & STREAM_SPRITE_Y,
+                            changes & STREAM_SPRITE_SOURCE, changes & STREAM_SPRITE_SOURCE,
+                            changes & STREAM_SPRITE_SOURCE, changes & STREAM_SPRITE_SOURCE};
+        for (int field = 0; field < 6; field++)
+        {
+            if (!hasField[field])
+                continue;
+            if (!ReadVarint(&cursor, end, &value))
+                return false;
+            *fields[field] += ZigZagDecode(value);
+        }
+    }
+
+    *frame = decoded;
+    return true;
+}
+
+void WriteVarint(unsigned char **cursor, unsigned int value)
+{
+    while (value >= 0x80)
+    {
+        *(*cursor)++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *(*cursor)++ = (unsigned char)value;
+}
+
+bool ReadVarint(const unsigned char **cursor, const unsigned char *end, unsigned int *value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 35 && *cursor < end; shift += 7)
+    {
+        unsigned char byte = *(*cursor)++;
+        *value |= (unsigned int)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+unsigned int ZigZagEncode(int value)
+{
+    return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+int ZigZagDecode(unsigned int value)
+{
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,132 @@
+/*******************************************************************************************
+ *
+ *   Dino spectator stream
+ *   Publishes the world each tick over TCP, delta-encoded against what each spectator has
+ *   acknowledged, and decodes it on the other end.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+#define MAX_SPECTATORS 32
+#define STREAM_HISTORY 64
+#define STREAM_BUFFER_SIZE 65536
+extern const int STREAM_DEFAULT_PORT;
+extern const int STREAM_KEYFRAME_INTERVAL;
+extern const int STREAM_REPORT_INTERVAL;
+extern const float STREAM_POSITION_SCALE;
+
+enum StreamSpriteChange
+{
+    STREAM_SPRITE_TEXTURE = 0b0001,
+    STREAM_SPRITE_X = 0b0010,
+    STREAM_SPRITE_Y = 0b0100,
+    STREAM_SPRITE_SOURCE = 0b1000,
+};
+
+enum StreamHudChange
+{
+    STREAM_HUD_STATE = 0b0001,
+    STREAM_HUD_SCORE = 0b0010,
+    STREAM_HUD_HIGHSCORE = 0b0100,
+    STREAM_HUD_SCROLL = 0b1000,
+};
+//----------------------------------------------------------------------------------
+
+// Types
+//----------------------------------------------------------------------------------
+// What a spectator needs to draw one tick. Positions are in 1/STREAM_POSITION_SCALE pixels.
+typedef struct StreamSprite
+{
+    bool isVisible;
+    int texture;
+    int x, y;
+    int sourceX, sourceY, sourceWidth, sourceHeight;
+} StreamSprite;
+
+typedef struct StreamFrame
+{
+    unsigned int tick;
+    int gameState;
+    int score;
+    int highScore;
+    int scrollIndex;
+    int spriteCount;
+    StreamSprite sprites[MAX_ENTITIES];
+} StreamFrame;
+
+typedef struct Spectator
+{
+    int socket;
+    bool hasAck;
+    unsigned int ackedTick;
+    unsigned int keyframeTick;
+    unsigned char ackBuffer[4];
+    int ackBytes;
+} Spectator;
+
+// Each message is delta-encoded against the last frame its spectator acknowledged, or sent
+// as a keyframe when there is no usable baseline.
+typedef struct StreamServer
+{
+    int listenSocket;
+    Spectator spectators[MAX_SPECTATORS];
+    int spectatorCount;
+    StreamFrame history[STREAM_HISTORY];
+    unsigned int tick;
+    long long bytesSent;
+    int messagesSent;
+    int keyframesSent;
+} StreamServer;
+
+typedef struct StreamClient
+{
+    int socket;
+    StreamFrame history[STREAM_HISTORY];
+    unsigned char buffer[STREAM_BUFFER_SIZE];
+    int bufferCount;
+    // Acks the socket could not take yet, sent ahead of any new ones
+    unsigned char ackBuffer[4 * STREAM_HISTORY];
+    int ackBytes;
+    long long bytesReceived;
+    int framesReceived;
+} StreamClient;
+//----------------------------------------------------------------------------------
+
+// Functions Declaration
+//----------------------------------------------------------------------------------
+bool StartStreamServer(StreamServer *server, int port);
+void StopStreamServer(StreamServer *server);
+void AcceptSpectators(StreamServer *server);
+void ReadSpectatorAcks(StreamServer *server);
+void RemoveSpectator(StreamServer *server, int index);
+void PublishStreamFrame(StreamServer *server, StreamFrame *frame);
+bool ConnectStreamClient(StreamClient *client, const char *host, int port);
+void DisconnectStreamClient(StreamClient *client);
+bool ReceiveStreamFrame(StreamClient *client, StreamFrame *frame);
+bool SendStreamAck(StreamClient *client, unsigned int ack);
+void DropStreamConnection(StreamClient *client, const char *reason);
+void CaptureStreamFrame(Entity *entities, GameVariables *game, int gameState, int highScore, StreamFrame *frame);
+void ApplyStreamFrame(Entity *entities, GameVariables *game, int *highScore, StreamFrame *frame);
+int EncodeStreamFrame(StreamFrame *frame, StreamFrame *base, unsigned int baseDistance, unsigned char *data);
+bool DecodeStreamFrame(const unsigned char *data, int size, StreamFrame *history, StreamFrame *frame);
+void WriteVarint(unsigned char **cursor, unsigned int value);
+bool ReadVarint(const unsigned char **cursor, const unsigned char *end, unsigned int *value);
+unsigned int ZigZagEncode(int value);
+int ZigZagDecode(unsigned int value);
+//----------------------------------------------------------------------------------
+
+#endif // STREAM_H
@@ -0,0 +1,282 @@
+/*******************************************************************************************
+ *
+ *   Dino telemetry
+ *   Filling blocks, the writer thread and reading blocks back.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "telemetry.h"
+#include <stdlib.h>
+//----------------------------------------------------------------------------------
+
+// Local Functions Declaration
+//----------------------------------------------------------------------------------
+TelemetryBlock *GetTelemetryBlock(TelemetryLog *log, TelemetryBlock **current, int table);
+void SubmitTelemetryBlock(TelemetryLog *log, TelemetryBlock **current);
+void *RunTelemetryWriter(void *argument);
+bool WriteTelemetryBlock(FILE *file, const TelemetryBlock *block);
+//----------------------------------------------------------------------------------
+
+// Telemetry Functions Definition
+// ----------------------------------------------------------------------------------
+bool OpenTelemetryLog(TelemetryLog *log, const char *fileName, unsigned int session)
+{
+    *log = (TelemetryLog){0};
+    log->session = session;
+    log->killer = TELEMETRY_NONE;
+    log->file = fopen(fileName, "ab");
+    if (log->file == NULL)
+    {
+        TraceLog(LOG_WARNING, "TELEMETRY: Could not open %s, not logging", fileName);
+        return false;
+    }
+
+    pthread_mutex_init(&log->mutex, NULL);
+    pthread_cond_init(&log->condition, NULL);
+    if (pthread_create(&log->thread, NULL, RunTelemetryWriter, log) != 0)
+    {
+        TraceLog(LOG_WARNING, "TELEMETRY: Could not start the writer thread, not logging");
+        pthread_cond_destroy(&log->condition);
+        pthread_mutex_destroy(&log->mutex);
+        fclose(log->file);
+        log->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Writes out whatever is still buffered and waits for the writer to finish
+void CloseTelemetryLog(TelemetryLog *log)
+{
+    if (log->file == NULL)
+        return;
+
+    SubmitTelemetryBlock(log, &log->events);
+    SubmitTelemetryBlock(log, &log->runs);
+    pthread_mutex_lock(&log->mutex);
+    log->isStopping = true;
+    pthread_cond_broadcast(&log->condition);
+    pthread_mutex_unlock(&log->mutex);
+    pthread_join(log->thread, NULL);
+
+    pthread_cond_destroy(&log->condition);
+    pthread_mutex_destroy(&log->mutex);
+    fclose(log->file);
+    log->file = NULL;
+    if (log->droppedBlocks > 0)
+    {
+        TraceLog(LOG_WARNING, "TELEMETRY: Dropped %i blocks the writer could not keep up with", log->droppedBlocks);
+    }
+}
+
+void LogTelemetryEvent(TelemetryLog *log, const SimEvent *event)
+{
+    if (log->file == NULL)
+        return;
+    TelemetryBlock *block = GetTelemetryBlock(log, &log->events, TELEMETRY_TABLE_EVENTS);
+    if (block == NULL)
+        return;
+
+    unsigned char obstacle = TELEMETRY_NONE;
+    unsigned char cluster = 0;
+    if (event->type == SIM_EVENT_SPAWN)
+    {
+        obstacle = (unsigned char)event->other;
+        cluster = (unsigned char)event->value;
+    }
+    if (event->type == SIM_EVENT_HIT)
+    {
+        obstacle = (unsigned char)event->value;
+        log->killer = obstacle;
+    }
+
+    unsigned int row = block->header.rows++;
+    block->events.run[row] = log->run;
+    block->events.tick[row] = (unsigned int)event->tick;
+    block->events.type[row] = (unsigned char)event->type;
+    block->events.obstacle[row] = obstacle;
+    block->events.cluster[row] = cluster;
+    if (block->header.rows == TELEMETRY_BLOCK_ROWS)
+    {
+        SubmitTelemetryBlock(log, &log->events);
+    }
+}
+
+// Call when a run ends; the events logged since the last call belong to it
+void LogTelemetryRun(TelemetryLog *log, unsigned int seed, GameVariables *game)
+{
+    if (log->file == NULL)
+        return;
+    TelemetryBlock *block = GetTelemetryBlock(log, &log->runs, TELEMETRY_TABLE_RUNS);
+    if (block == NULL)
+        return;
+
+    unsigned int row = block->header.rows++;
+    block->runs.run[row] = log->run;
+    block->runs.seed[row] = seed;
+    block->runs.ticks[row] = (unsigned int)game->frameCounter;
+    block->runs.score[row] = (unsigned int)game->score;
+    block->runs.speed[row] = ScalarToFloat(game->scrollMultiplier);
+    block->runs.killer[row] = log->killer;
+    // Hand over the partial blocks too, so a session that is killed keeps every finished run
+    SubmitTelemetryBlock(log, &log->events);
+    SubmitTelemetryBlock(log, &log->runs);
+
+    log->run++;
+    log->killer = TELEMETRY_NONE;
+}
+
+// Returns false at the end of the file or at the first block that does not make sense
+bool ReadTelemetryBlock(FILE *file, TelemetryBlock *block)
+{
+    TelemetryBlockHeader *header = &block->header;
+    if (fread(header, sizeof(*header), 1, file) != 1)
+        return false;
+    if (header->magic != TELEMETRY_MAGIC || header->version != TELEMETRY_VERSION || header->rows > TELEMETRY_BLOCK_ROWS)
+    {
+        TraceLog(LOG_WARNING, "TELEMETRY: Unreadable block, stopping");
+        return false;
+    }
+
+    size_t rows = header->rows;
+    bool isRead = false;
+    switch (header->table)
+    {
+    case TELEMETRY_TABLE_EVENTS:
+        isRead = fread(block->events.run, sizeof(unsigned int), rows, file) == rows &&
+                 fread(block->events.tick, sizeof(unsigned int), rows, file) == rows &&
+                 fread(block->events.type, sizeof(unsigned char), rows, file) == rows &&
+                 fread(block->events.obstacle, sizeof(unsigned char), rows, file) == rows &&
+                 fread(block->events.cluster, sizeof(unsigned char), rows, file) == rows;
+        break;
+    case TELEMETRY_TABLE_RUNS:
+        isRead = fread(block->runs.run, sizeof(unsigned int), rows, file) == rows &&
+                 fread(block->runs.seed, sizeof(unsigned int), rows, file) == rows &&
+                 fread(block->runs.ticks, sizeof(unsigned int), rows, file) == rows &&
+                 fread(block->runs.score, sizeof(unsigned int), rows, file) == rows &&
+                 fread(block->runs.speed, sizeof(float), rows, file) == rows &&
+                 fread(block->runs.killer, sizeof(unsigned char), rows, file) == rows;
+        break;
+    }
+    if (!isRead)
+    {
+        TraceLog(LOG_WARNING, "TELEMETRY: Truncated block, stopping");
+    }
+    return isRead;
+}
+// ----------------------------------------------------------------------------------
+
+// Writer Functions Definition
+// ----------------------------------------------------------------------------------
+TelemetryBlock *GetTelemetryBlock(TelemetryLog *log, TelemetryBlock **current, int table)
+{
+    if (*current == NULL)
+    {
+        *current = malloc(sizeof(TelemetryBlock));
+        if (*current == NULL)
+        {
+            log->droppedBlocks++;
+            return NULL;
+        }
+        (*current)->header = (TelemetryBlockHeader){TELEMETRY_MAGIC, TELEMETRY_VERSION, (unsigned short)table, log->session, 0};
+    }
+    return *current;
+}
+
+// Queues the block for the writer. The lock is only ever held to move a pointer, and a full
+// queue drops the block rather than waiting.
+void SubmitTelemetryBlock(TelemetryLog *log, TelemetryBlock **current)
+{
+    TelemetryBlock *block = *current;
+    *current = NULL;
+    if (block == NULL)
+        return;
+    if (block->header.rows == 0)
+    {
+        free(block);
+        return;
+    }
+
+    pthread_mutex_lock(&log->mutex);
+    if (log->queueCount == TELEMETRY_QUEUE_BLOCKS)
+    {
+        log->droppedBlocks++;
+        pthread_mutex_unlock(&log->mutex);
+        free(block);
+        return;
+    }
+    log->queue[(log->queueHead + log->queueCount) % TELEMETRY_QUEUE_BLOCKS] = block;
+    log->queueCount++;
+    pthread_cond_signal(&log->condition);
+    pthread_mutex_unlock(&log->mutex);
+}
+
+void *RunTelemetryWriter(void *argument)
+{
+    TelemetryLog *log = argument;
+    pthread_mutex_lock(&log->mutex);
+    while (true)
+    {
+        while (log->queueCount == 0 && !log->isStopping)
+        {
+            pthread_cond_wait(&log->condition, &log->mutex);
+        }
+        if (log->queueCount == 0)
+            break;
+
+        TelemetryBlock *block = log->queue[log->queueHead];
+        log->queueHead = (log->queueHead + 1) % TELEMETRY_QUEUE_BLOCKS;
+        log->queueCount--;
+        bool isQueueEmpty = log->queueCount == 0;
+        pthread_mutex_unlock(&log->mutex);
+
+        if (!WriteTelemetryBlock(log->file, block))
+        {
+            TraceLog(LOG_WARNING, "TELEMETRY: Write failed, the log may be truncated");
+        }
+        free(block);
+        // Out to the OS before going back to sleep
+        if (isQueueEmpty)
+        {
+            fflush(log->file);
+        }
+
+        pthread_mutex_lock(&log->mutex);
+    }
+    pthread_mutex_unlock(&log->mutex);
+    fflush(log->file);
+    return NULL;
+}
+
+bool WriteTelemetryBlock(FILE *file, const TelemetryBlock *block)
+{
+    size_t rows = block->header.rows;
+    if (fwrite(&block->header, sizeof(block->header), 1, file) != 1)
+        return false;
+
+    switch (block->header.table)
+    {
+    case TELEMETRY_TABLE_EVENTS:
+        return fwrite(block->events.run, sizeof(unsigned int), rows, file) == rows &&
+               fwrite(block->events.tick, sizeof(unsigned int), rows, file) == rows &&
+               fwrite(block->events.type, sizeof(unsigned char), rows, file) == rows &&
+               fwrite(block->events.obstacle, sizeof(unsigned char), rows, file) == rows &&
+               fwrite(block->events.cluster, sizeof(unsigned char), rows, file) == rows;
+    case TELEMETRY_TABLE_RUNS:
+        return fwrite(block->runs.run, sizeof(unsigned int), rows, file) == rows &&
+               fwrite(block->runs.seed, sizeof(unsigned int), rows, file) == rows &&
+               fwrite(block->runs.ticks, sizeof(unsigned int), rows, file) == rows &&
+               fwrite(block->runs.score, sizeof(unsigned int), rows, file) == rows &&
+               fwrite(block->runs.speed, sizeof(float), rows, file) == rows &&
+               fwrite(block->runs.killer, sizeof(unsigned char), rows, file) == rows;
+    }
+    return false;
+}
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+/*******************************************************************************************
+ *
+ *   Dino telemetry
+ *   An append-only binary log of every run and the events in it, laid out in columns so
+ *   millions of runs can be aggregated without parsing. Rows are gathered into blocks on
+ *   the caller's thread, handed over when a block fills or a run ends, and written out by a
+ *   background thread, so logging never waits on the disk; if the writer falls too far
+ *   behind, whole blocks are dropped and counted.
+ *
+ *   A file is a sequence of blocks. Each block is a TelemetryBlockHeader followed by one
+ *   array per column, in the order the columns are declared below, rows entries each.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+#include <pthread.h>
+#include <stdio.h>
+//----------------------------------------------------------------------------------
+
+// Constants
+//----------------------------------------------------------------------------------
+#define TELEMETRY_MAGIC 0x4d4c5444 // "DTLM"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_BLOCK_ROWS 4096
+#define TELEMETRY_QUEUE_BLOCKS 16
+#define TELEMETRY_NONE 0xff
+
+typedef enum TelemetryTable
+{
+    TELEMETRY_TABLE_EVENTS,
+    TELEMETRY_TABLE_RUNS,
+} TelemetryTable;
+//----------------------------------------------------------------------------------
+
+// Telemetry Types
+//----------------------------------------------------------------------------------
+// session is picked when the log is opened; run counts up from 0 within a session
+typedef struct TelemetryBlockHeader
+{
+    unsigned int magic;
+    unsigned short version;
+    unsigned short table;
+    unsigned int session;
+    unsigned int rows;
+} TelemetryBlockHeader;
+
+// One row per SimEvent. obstacle is the ObstacleType for spawns and hits, TELEMETRY_NONE
+// otherwise; cluster is the cluster size for spawns.
+typedef struct TelemetryEventColumns
+{
+    unsigned int run[TELEMETRY_BLOCK_ROWS];
+    unsigned int tick[TELEMETRY_BLOCK_ROWS];
+    unsigned char type[TELEMETRY_BLOCK_ROWS];
+    unsigned char obstacle[TELEMETRY_BLOCK_ROWS];
+    unsigned char cluster[TELEMETRY_BLOCK_ROWS];
+} TelemetryEventColumns;
+
+// One row per finished run. speed is scrollMultiplier at death and killer the ObstacleType
+// that ended the run.
+typedef struct TelemetryRunColumns
+{
+    unsigned int run[TELEMETRY_BLOCK_ROWS];
+    unsigned int seed[TELEMETRY_BLOCK_ROWS];
+    unsigned int ticks[TELEMETRY_BLOCK_ROWS];
+    unsigned int score[TELEMETRY_BLOCK_ROWS];
+    float speed[TELEMETRY_BLOCK_ROWS];
+    unsigned char killer[TELEMETRY_BLOCK_ROWS];
+} TelemetryRunColumns;
+
+typedef struct TelemetryBlock
+{
+    TelemetryBlockHeader header;
+    union
+    {
+        TelemetryEventColumns events;
+        TelemetryRunColumns runs;
+    };
+} TelemetryBlock;
+
+typedef struct TelemetryLog
+{
+    FILE *file;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    TelemetryBlock *queue[TELEMETRY_QUEUE_BLOCKS];
+    int queueHead;
+    int queueCount;
+    bool isStopping;
+
+    TelemetryBlock *events;
+    TelemetryBlock *runs;
+    unsigned int session;
+    unsigned int run;
+    unsigned char killer;
+    int droppedBlocks;
+} TelemetryLog;
+//----------------------------------------------------------------------------------
+
+// Functions Declaration
+//----------------------------------------------------------------------------------
+bool OpenTelemetryLog(TelemetryLog *log, const char *fileName, unsigned int session);
+void CloseTelemetryLog(TelemetryLog *log);
+void LogTelemetryEvent(TelemetryLog *log, const SimEvent *event);
+void LogTelemetryRun(TelemetryLog *log, unsigned int seed, GameVariables *game);
+bool ReadTelemetryBlock(FILE *file, TelemetryBlock *block);
+//----------------------------------------------------------------------------------
+
+#endif
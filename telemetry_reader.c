@@ -0,0 +1,231 @@
+/*******************************************************************************************
+ *
+ *   Dino telemetry reader
+ *   dino_telemetry file...
+ *   Aggregates one or more telemetry logs, a column at a time, into a balancing summary:
+ *   scores and speed at death, what killed the dino, what was spawned, and how long jumps
+ *   and ducks lasted.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "telemetry.h"
+#include <stdlib.h>
+//----------------------------------------------------------------------------------
+
+// Local Types Definition
+//----------------------------------------------------------------------------------
+#define MAX_CLUSTER_SIZE 4
+#define OBSTACLE_TYPE_COUNT 3
+
+typedef struct TelemetrySummary
+{
+    long long runs;
+    long long events;
+    long long totalScore;
+    long long totalTicks;
+    double totalSpeed;
+    unsigned int bestScore;
+    long long deaths[OBSTACLE_TYPE_COUNT + 1];
+    long long eventCounts[256];
+    long long spawns[OBSTACLE_TYPE_COUNT][MAX_CLUSTER_SIZE + 1];
+
+    // Pairs of events are matched within one run of one session
+    unsigned int session;
+    unsigned int run;
+    long long jumpTick;
+    long long duckTick;
+    long long airTicks;
+    long long airCount;
+    long long duckTicks;
+    long long duckCount;
+} TelemetrySummary;
+
+const char *OBSTACLE_NAMES[OBSTACLE_TYPE_COUNT + 1] = {"cactus_large", "cactus_small", "pterodactyl", "none"};
+//----------------------------------------------------------------------------------
+
+// Local Functions Declaration
+//----------------------------------------------------------------------------------
+bool ReadTelemetryFile(const char *fileName, TelemetrySummary *summary, TelemetryBlock *block);
+void AddRunColumns(TelemetrySummary *summary, const TelemetryBlock *block);
+void AddEventColumns(TelemetrySummary *summary, const TelemetryBlock *block);
+void PrintTelemetrySummary(const TelemetrySummary *summary);
+//----------------------------------------------------------------------------------
+
+// Main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s file...\n", argv[0]);
+        return 1;
+    }
+
+    TelemetrySummary *summary = calloc(1, sizeof(TelemetrySummary));
+    TelemetryBlock *block = malloc(sizeof(TelemetryBlock));
+    summary->jumpTick = -1;
+    summary->duckTick = -1;
+
+    double startTime = GetWallTime();
+    for (int i = 1; i < argc; i++)
+    {
+        ReadTelemetryFile(argv[i], summary, block);
+    }
+    double elapsed = GetWallTime() - startTime;
+
+    PrintTelemetrySummary(summary);
+    printf("read_seconds %.3f\n", elapsed);
+
+    free(block);
+    free(summary);
+    return 0;
+}
+// ----------------------------------------------------------------------------------
+
+// Aggregate Functions Definition
+// ----------------------------------------------------------------------------------
+bool ReadTelemetryFile(const char *fileName, TelemetrySummary *summary, TelemetryBlock *block)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "could not open %s\n", fileName);
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    while (ReadTelemetryBlock(file, block))
+    {
+        if (block->header.table == TELEMETRY_TABLE_RUNS)
+        {
+            AddRunColumns(summary, block);
+        }
+        else if (block->header.table == TELEMETRY_TABLE_EVENTS)
+        {
+            AddEventColumns(summary, block);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+void AddRunColumns(TelemetrySummary *summary, const TelemetryBlock *block)
+{
+    const TelemetryRunColumns *runs = &block->runs;
+    int rows = (int)block->header.rows;
+
+    long long totalScore = 0;
+    long long totalTicks = 0;
+    double totalSpeed = 0.0;
+    unsigned int bestScore = summary->bestScore;
+    for (int i = 0; i < rows; i++)
+    {
+        totalScore += runs->score[i];
+        totalTicks += runs->ticks[i];
+        totalSpeed += runs->speed[i];
+        bestScore = runs->score[i] > bestScore ? runs->score[i] : bestScore;
+    }
+    for (int i = 0; i < rows; i++)
+    {
+        int killer = runs->killer[i] < OBSTACLE_TYPE_COUNT ? runs->killer[i] : OBSTACLE_TYPE_COUNT;
+        summary->deaths[killer]++;
+    }
+
+    summary->runs += rows;
+    summary->totalScore += totalScore;
+    summary->totalTicks += totalTicks;
+    summary->totalSpeed += totalSpeed;
+    summary->bestScore = bestScore;
+}
+
+void AddEventColumns(TelemetrySummary *summary, const TelemetryBlock *block)
+{
+    const TelemetryEventColumns *events = &block->events;
+    int rows = (int)block->header.rows;
+
+    for (int i = 0; i < rows; i++)
+    {
+        summary->eventCounts[events->type[i]]++;
+    }
+    for (int i = 0; i < rows; i++)
+    {
+        if (events->type[i] != SIM_EVENT_SPAWN || events->obstacle[i] >= OBSTACLE_TYPE_COUNT)
+            continue;
+        int cluster = events->cluster[i] < MAX_CLUSTER_SIZE ? events->cluster[i] : MAX_CLUSTER_SIZE;
+        summary->spawns[events->obstacle[i]][cluster]++;
+    }
+
+    // Air and duck time need the events in order
+    for (int i = 0; i < rows; i++)
+    {
+        if (block->header.session != summary->session || events->run[i] != summary->run)
+        {
+            summary->session = block->header.session;
+            summary->run = events->run[i];
+            summary->jumpTick = -1;
+            summary->duckTick = -1;
+        }
+        switch (events->type[i])
+        {
+        case SIM_EVENT_JUMP:
+            summary->jumpTick = events->tick[i];
+            break;
+        case SIM_EVENT_LAND:
+            if (summary->jumpTick >= 0)
+            {
+                summary->airTicks += events->tick[i] - summary->jumpTick;
+                summary->airCount++;
+            }
+            summary->jumpTick = -1;
+            break;
+        case SIM_EVENT_DUCK:
+            summary->duckTick = events->tick[i];
+            break;
+        case SIM_EVENT_STAND:
+            if (summary->duckTick >= 0)
+            {
+                summary->duckTicks += events->tick[i] - summary->duckTick;
+                summary->duckCount++;
+            }
+            summary->duckTick = -1;
+            break;
+        }
+    }
+    summary->events += rows;
+}
+
+void PrintTelemetrySummary(const TelemetrySummary *summary)
+{
+    long long runs = summary->runs > 0 ? summary->runs : 1;
+    printf("runs %lld\n", summary->runs);
+    printf("events %lld\n", summary->events);
+    printf("mean_score %.1f\n", (double)summary->totalScore / runs);
+    printf("best_score %u\n", summary->bestScore);
+    printf("mean_ticks %.1f\n", (double)summary->totalTicks / runs);
+    printf("mean_speed_at_death %.3f\n", summary->totalSpeed / runs);
+    for (int type = 0; type <= OBSTACLE_TYPE_COUNT; type++)
+    {
+        printf("deaths_%s %lld %.1f%%\n", OBSTACLE_NAMES[type], summary->deaths[type], 100.0 * summary->deaths[type] / runs);
+    }
+    for (int type = 0; type < OBSTACLE_TYPE_COUNT; type++)
+    {
+        for (int cluster = 1; cluster <= MAX_CLUSTER_SIZE; cluster++)
+        {
+            if (summary->spawns[type][cluster] == 0)
+                continue;
+            printf("spawns_%s_x%i %lld\n", OBSTACLE_NAMES[type], cluster, summary->spawns[type][cluster]);
+        }
+    }
+    printf("jumps_per_run %.2f\n", (double)summary->eventCounts[SIM_EVENT_JUMP] / runs);
+    printf("ducks_per_run %.2f\n", (double)summary->eventCounts[SIM_EVENT_DUCK] / runs);
+    printf("mean_air_ticks %.2f\n", summary->airCount > 0 ? (double)summary->airTicks / summary->airCount : 0.0);
+    printf("mean_duck_ticks %.2f\n", summary->duckCount > 0 ? (double)summary->duckTicks / summary->duckCount : 0.0);
+}
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,453 @@
+/*******************************************************************************************
+ *
+ *   Dino tests
+ *   Runs the simulation library without a window and checks what the rest of the game
+ *   relies on. Prints one "name ok" or "name FAILED" line per test and exits non-zero if
+ *   any failed.
+ *
+ *   Usage: dino_tests [test name...]
+ *
+ *   world_hash prints the hash of the world it ends in; built with DINO_FIXED_POINT, ctest
+ *   compares it with the same test built without optimisation.
+ *
+ *   Copyright & License:
+ *   This code is licensed under the ISC License.
+ *   (https://www.github.com/richardstephens-dev/chrome-dino-game-c-clone)
+ *   Copyright (c) 2023 Richard J Stephens
+ *
+ ********************************************************************************************/
+
+// Includes
+//----------------------------------------------------------------------------------
+#include "dino.h"
+#include "ghost.h"
+#include "render.h"
+#include "stream.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+//----------------------------------------------------------------------------------
+
+// Local Types Definition
+//----------------------------------------------------------------------------------
+typedef struct DinoTest
+{
+    const char *name;
+    bool (*run)();
+} DinoTest;
+//----------------------------------------------------------------------------------
+
+// Local Functions Declaration
+//----------------------------------------------------------------------------------
+bool TestSnapshotRoundTrip();
+bool TestStreamEncodeDecode();
+bool TestRestoreReplaysTrajectory();
+bool TestStreamLoopback();
+bool TestWorldHash();
+bool TestDuckTapKeepsJump();
+bool TestGhostFile();
+bool TestRenderSortGroupsTextures();
+bool Check(bool condition, const char *message);
+void StepWorld(int ticks);
+unsigned long long HashWorld();
+int RunScriptedInput(int ticks, PositionComponent *trajectory, unsigned char *snapshot);
+bool IsStreamFrameEqual(const StreamFrame *a, const StreamFrame *b);
+//----------------------------------------------------------------------------------
+
+// Local Variables Definition
+//----------------------------------------------------------------------------------
+const DinoTest TESTS[] = {
+    {"snapshot_round_trip", TestSnapshotRoundTrip},
+    {"stream_encode_decode", TestStreamEncodeDecode},
+    {"restore_replays_trajectory", TestRestoreReplaysTrajectory},
+    {"stream_loopback", TestStreamLoopback},
+    {"world_hash", TestWorldHash},
+    {"duck_tap_keeps_jump", TestDuckTapKeepsJump},
+    {"ghost_file", TestGhostFile},
+    {"render_sort_groups_textures", TestRenderSortGroupsTextures},
+};
+const int TEST_COUNT = sizeof(TESTS) / sizeof(TESTS[0]);
+
+Entity entities[MAX_ENTITIES];
+GameVariables game;
+int dinoId;
+unsigned char startSnapshot[MAX_WORLD_SNAPSHOT_SIZE];
+int startSnapshotSize;
+//----------------------------------------------------------------------------------
+
+// Main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    SetTraceLogLevel(LOG_WARNING);
+    LoadSpriteTextures(true);
+    SetWorldRandomSeed(1);
+    dinoId = CreateWorld(entities, &game);
+    startSnapshotSize = SaveWorldSnapshot(entities, &game, startSnapshot, sizeof(startSnapshot));
+
+    int failures = 0;
+    for (int i = 0; i < TEST_COUNT; i++)
+    {
+        bool isSelected = argc < 2;
+        for (int arg = 1; arg < argc; arg++)
+        {
+            isSelected |= strcmp(argv[arg], TESTS[i].name) == 0;
+        }
+        if (!isSelected)
+            continue;
+
+        RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+        bool isPassed = TESTS[i].run();
+        printf("%s %s\n", TESTS[i].name, isPassed ? "ok" : "FAILED");
+        failures += !isPassed;
+    }
+
+    UnloadSpriteTextures(true);
+    return failures > 0 ? 1 : 0;
+}
+// ----------------------------------------------------------------------------------
+
+// Test Functions Definition
+// ----------------------------------------------------------------------------------
+// Loading a snapshot and saving it again gives back the same bytes, and a cut-off
+// snapshot is refused
+bool TestSnapshotRoundTrip()
+{
+    static unsigned char saved[MAX_WORLD_SNAPSHOT_SIZE];
+    static unsigned char resaved[MAX_WORLD_SNAPSHOT_SIZE];
+    StepWorld(500);
+    int size = SaveWorldSnapshot(entities, &game, saved, sizeof(saved));
+    StepWorld(100);
+
+    bool isPassed = Check(size > 0, "snapshot saved");
+    isPassed &= Check(LoadWorldSnapshot(entities, &game, saved, size), "snapshot loaded");
+    int resavedSize = SaveWorldSnapshot(entities, &game, resaved, sizeof(resaved));
+    isPassed &= Check(resavedSize == size && memcmp(saved, resaved, size) == 0, "reloaded world saves the same bytes");
+    isPassed &= Check(!LoadWorldSnapshot(entities, &game, saved, size - 1), "truncated snapshot refused");
+    return isPassed;
+}
+
+// Every tick decodes to exactly what was captured, from a keyframe and then from deltas
+// against the tick before
+bool TestStreamEncodeDecode()
+{
+    static StreamFrame frames[2];
+    static StreamFrame history[STREAM_HISTORY];
+    static StreamFrame decoded;
+    static unsigned char message[STREAM_BUFFER_SIZE];
+    const int ticks = 600;
+
+    bool isPassed = true;
+    long long keyframeBytes = 0;
+    long long deltaBytes = 0;
+    for (int tick = 0; tick < ticks && isPassed; tick++)
+    {
+        StepWorld(1);
+        StreamFrame *frame = &frames[tick % 2];
+        StreamFrame *base = tick > 0 ? &frames[(tick + 1) % 2] : NULL;
+        CaptureStreamFrame(entities, &game, PLAYING, 0, frame);
+        frame->tick = (unsigned int)tick;
+
+        int size = EncodeStreamFrame(frame, base, base != NULL ? 1 : 0, message);
+        if (base == NULL)
+        {
+            keyframeBytes += size;
+        }
+        else
+        {
+            deltaBytes += size;
+        }
+        isPassed &= Check(DecodeStreamFrame(message + 4, size - 4, history, &decoded), "frame decoded");
+        isPassed &= Check(IsStreamFrameEqual(frame, &decoded), "decoded frame matches the captured one");
+        history[decoded.tick % STREAM_HISTORY] = decoded;
+    }
+    isPassed &= Check(deltaBytes < keyframeBytes * (ticks - 1), "deltas are smaller than keyframes");
+    return isPassed;
+}
+
+// Restoring a snapshot and stepping through the same input again follows the original run
+// exactly, tick by tick, and ends in the same world
+bool TestRestoreReplaysTrajectory()
+{
+    static unsigned char start[MAX_WORLD_SNAPSHOT_SIZE];
+    static unsigned char firstEnd[MAX_WORLD_SNAPSHOT_SIZE];
+    static unsigned char secondEnd[MAX_WORLD_SNAPSHOT_SIZE];
+    static PositionComponent firstTrajectory[2000];
+    static PositionComponent secondTrajectory[2000];
+    const int ticks = 2000;
+
+    StepWorld(300);
+    int startSize = SaveWorldSnapshot(entities, &game, start, sizeof(start));
+    int firstSize = RunScriptedInput(ticks, firstTrajectory, firstEnd);
+
+    bool isPassed = Check(LoadWorldSnapshot(entities, &game, start, startSize), "start restored");
+    int secondSize = RunScriptedInput(ticks, secondTrajectory, secondEnd);
+    isPassed &= Check(memcmp(firstTrajectory, secondTrajectory, sizeof(firstTrajectory)) == 0, "dino trajectory replayed");
+    isPassed &= Check(firstSize == secondSize && memcmp(firstEnd, secondEnd, firstSize) == 0, "final world replayed");
+    return isPassed;
+}
+
+// A server and a spectator on loopback: every published tick arrives intact, acks turn the
+// stream into deltas, it reports the bytes per tick it took, and the spectator drops the
+// connection once the server is gone
+bool TestStreamLoopback()
+{
+    static StreamFrame sent;
+    static StreamFrame received;
+    const int ticks = 600;
+
+    // Port 0 lets the system pick a free one
+    StreamServer *server = calloc(1, sizeof(StreamServer));
+    StreamClient *client = calloc(1, sizeof(StreamClient));
+    if (!Check(StartStreamServer(server, 0), "server started"))
+    {
+        free(server);
+        free(client);
+        return false;
+    }
+    struct sockaddr_in address = {0};
+    socklen_t addressSize = sizeof(address);
+    getsockname(server->listenSocket, (struct sockaddr *)&address, &addressSize);
+    bool isPassed = Check(ConnectStreamClient(client, "127.0.0.1", ntohs(address.sin_port)), "spectator connected");
+
+    for (int tick = 0; tick < ticks && isPassed; tick++)
+    {
+        StepWorld(1);
+        CaptureStreamFrame(entities, &game, PLAYING, 0, &sent);
+        PublishStreamFrame(server, &sent);
+
+        bool hasFrame = false;
+        double timeout = GetWallTime() + 1.0;
+        while (!(hasFrame = ReceiveStreamFrame(client, &received)) && GetWallTime() < timeout)
+        {
+            usleep(100);
+        }
+        isPassed &= Check(hasFrame, "frame arrived");
+        isPassed &= Check(hasFrame && IsStreamFrameEqual(&sent, &received), "received frame matches the published one");
+    }
+    isPassed &= Check(server->keyframesSent <= ticks / STREAM_KEYFRAME_INTERVAL + 2, "acked frames sent as deltas");
+    printf("  %.1f bytes/tick, %i keyframes\n", server->messagesSent > 0 ? (double)server->bytesSent / server->messagesSent : 0.0, server->keyframesSent);
+
+    // Once the server stops, the spectator notices and lets go of the socket
+    StopStreamServer(server);
+    double timeout = GetWallTime() + 1.0;
+    while (ReceiveStreamFrame(client, &received) || (client->socket >= 0 && GetWallTime() < timeout))
+    {
+        usleep(100);
+    }
+    isPassed &= Check(client->socket < 0, "closed connection dropped");
+
+    DisconnectStreamClient(client);
+    free(client);
+    free(server);
+    return isPassed;
+}
+
+// The same seed played twice ends in the same world. The hash is printed so builds with
+// different flags can be compared against each other.
+bool TestWorldHash()
+{
+    const int ticks = 5000;
+
+    StepWorld(ticks);
+    unsigned long long firstHash = HashWorld();
+    RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+    StepWorld(ticks);
+    unsigned long long secondHash = HashWorld();
+
+    printf("  world hash %016llx after %i ticks\n", firstHash, ticks);
+    return Check(firstHash == secondHash, "same seed ends in the same world");
+}
+
+// A duck pressed and released in one tick holds for that tick, and a jump queued behind
+// the release still lands on the same tick
+bool TestDuckTapKeepsJump()
+{
+    ClearInputEvents(entities);
+    int tick = game.frameCounter;
+    PushInputEvent(INPUT_DUCK, true, 0.0, tick);
+    PushInputEvent(INPUT_DUCK, false, 0.0, tick);
+    PushInputEvent(INPUT_JUMP, true, 0.0, tick);
+
+    UpdateWorld(entities, &game);
+    bool isPassed = Check(dinoComponents[dinoId].isJumping, "jump applied on its tick");
+    isPassed &= Check(inputComponents[dinoId].duckHeld, "duck held through the tap's tick");
+    UpdateWorld(entities, &game);
+    isPassed &= Check(!inputComponents[dinoId].duckHeld, "duck released on the next tick");
+    isPassed &= Check(inputQueue.count == 0, "queue drained");
+    return isPassed;
+}
+
+// Runs saved on two seeds load back by seed and play to the recorded end. A run cut off by
+// a truncated file is not loaded.
+bool TestGhostFile()
+{
+    const char *fileName = "/tmp/dino_tests_ghosts.bin";
+    remove(fileName);
+    GhostRecorder recorder = {0};
+    StartGhostRecording(&recorder, 1);
+    for (int i = 0; i < 600; i++)
+    {
+        StepWorld(1);
+        RecordGhostSample(&recorder, dinoId);
+    }
+    bool isPassed = Check(SaveGhostRun(fileName, &recorder.run), "first run saved");
+    recorder.run.seed = 2;
+    isPassed &= Check(SaveGhostRun(fileName, &recorder.run), "second run saved");
+
+    unsigned int seed = 0;
+    isPassed &= Check(GetLastGhostSeed(fileName, &seed) && seed == 2, "last seed found");
+    GhostLayer ghosts = {0};
+    isPassed &= Check(LoadGhostRuns(&ghosts, fileName, 1) == 1, "run loaded by seed");
+    UpdateGhostLayer(&ghosts, recorder.run.tickCount);
+    isPassed &= Check(ghosts.count == 1 && ghosts.x[0] == (short)lroundf(ScalarToFloat(positionComponents[dinoId].x)),
+                      "ghost ends where the dino did");
+    UpdateGhostLayer(&ghosts, recorder.run.tickCount + 1);
+    isPassed &= Check(ghosts.poses[0] == GHOST_POSE_HIDDEN, "ghost hidden once its run ends");
+    UnloadGhostLayer(&ghosts);
+
+    // Cut the second run short
+    FILE *file = fopen(fileName, "r+b");
+    fseek(file, 0, SEEK_END);
+    isPassed &= Check(ftruncate(fileno(file), ftell(file) - 3) == 0, "file truncated");
+    fclose(file);
+    isPassed &= Check(LoadGhostRuns(&ghosts, fileName, 2) == 0, "truncated run refused");
+    isPassed &= Check(LoadGhostRuns(&ghosts, fileName, 1) == 1, "runs before it still load");
+
+    UnloadGhostLayer(&ghosts);
+    UnloadGhostRecording(&recorder);
+    remove(fileName);
+    return isPassed;
+}
+
+// Sprites in a layer come out of the sort grouped by texture, layers stay back to front, and
+// sprites that share a texture keep the order they were built in
+bool TestRenderSortGroupsTextures()
+{
+    static RenderCommandList list;
+    Texture2D cactus = spriteTextures[TEXTURE_CACTUS_SMALL];
+    Texture2D pterodactyl = spriteTextures[TEXTURE_PTERODACTYL];
+    Texture2D cloud = spriteTextures[TEXTURE_CLOUD];
+    RenderCommand built[] = {
+        {GetRenderSortKey(RENDER_LAYER_GROUND, cactus.id), cactus, {0}, {0.0f, 0.0f}},
+        {GetRenderSortKey(RENDER_LAYER_GROUND, pterodactyl.id), pterodactyl, {0}, {1.0f, 0.0f}},
+        {GetRenderSortKey(RENDER_LAYER_SKY, cloud.id), cloud, {0}, {2.0f, 0.0f}},
+        {GetRenderSortKey(RENDER_LAYER_GROUND, cactus.id), cactus, {0}, {3.0f, 0.0f}},
+    };
+    list.count = sizeof(built) / sizeof(built[0]);
+    memcpy(list.commands, built, sizeof(built));
+    SortRenderCommands(&list);
+
+    bool isPassed = Check(list.commands[0].texture.id == cloud.id, "sky layer drawn first");
+    int firstCactus = cactus.id < pterodactyl.id ? 1 : 2;
+    isPassed &= Check(list.commands[firstCactus].texture.id == cactus.id && list.commands[firstCactus + 1].texture.id == cactus.id,
+                      "same-texture commands next to each other");
+    isPassed &= Check(list.commands[firstCactus].position.x == 0.0f && list.commands[firstCactus + 1].position.x == 3.0f,
+                      "same-texture commands keep their order");
+
+    // And over a real world: each texture appears as one run within its layer
+    StepWorld(400);
+    BuildRenderCommands(entities, &list);
+    SortRenderCommands(&list);
+    for (int i = 0; i < list.count; i++)
+    {
+        for (int j = i + 2; j < list.count; j++)
+        {
+            if (list.commands[j].key == list.commands[i].key && list.commands[j - 1].key != list.commands[i].key)
+            {
+                isPassed &= Check(false, "texture split into two runs");
+                return isPassed;
+            }
+        }
+    }
+    return isPassed;
+}
+// ----------------------------------------------------------------------------------
+
+// Helper Functions Definition
+// ----------------------------------------------------------------------------------
+bool Check(bool condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("  failed: %s\n", message);
+    }
+    return condition;
+}
+
+// The reflex bot plays, restarting on the same seed whenever it dies
+void StepWorld(int ticks)
+{
+    for (int i = 0; i < ticks; i++)
+    {
+        UpdateReflexBot(entities, &game, dinoId);
+        UpdateWorld(entities, &game);
+        if (dinoComponents[dinoId].isDead)
+        {
+            RestartWorld(entities, &game, startSnapshot, startSnapshotSize, 1);
+        }
+    }
+}
+
+// FNV-1a over the world snapshot
+unsigned long long HashWorld()
+{
+    static unsigned char snapshot[MAX_WORLD_SNAPSHOT_SIZE];
+    int size = SaveWorldSnapshot(entities, &game, snapshot, sizeof(snapshot));
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int i = 0; i < size; i++)
+    {
+        hash = (hash ^ snapshot[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Jumps, and ducks held for 20 ticks, on a fixed schedule. Records the dino's position
+// every tick and saves the world at the end.
+int RunScriptedInput(int ticks, PositionComponent *trajectory, unsigned char *snapshot)
+{
+    ClearInputEvents(entities);
+    for (int i = 0; i < ticks; i++)
+    {
+        int tick = game.frameCounter;
+        if (i % 45 == 0)
+        {
+            PushInputEvent(INPUT_JUMP, true, 0.0, tick);
+        }
+        if (i % 120 == 60)
+        {
+            PushInputEvent(INPUT_DUCK, true, 0.0, tick);
+        }
+        if (i % 120 == 80)
+        {
+            PushInputEvent(INPUT_DUCK, false, 0.0, tick);
+        }
+        UpdateWorld(entities, &game);
+        trajectory[i] = positionComponents[dinoId];
+    }
+    return SaveWorldSnapshot(entities, &game, snapshot, MAX_WORLD_SNAPSHOT_SIZE);
+}
+
+// Field by field, since StreamSprite has padding
+bool IsStreamFrameEqual(const StreamFrame *a, const StreamFrame *b)
+{
+    if (a->tick != b->tick || a->gameState != b->gameState || a->score != b->score ||
+        a->highScore != b->highScore || a->scrollIndex != b->scrollIndex || a->spriteCount != b->spriteCount)
+        return false;
+    for (int i = 0; i < a->spriteCount; i++)
+    {
+        const StreamSprite *spriteA = &a->sprites[i];
+        const StreamSprite *spriteB = &b->sprites[i];
+        if (spriteA->isVisible != spriteB->isVisible || spriteA->texture != spriteB->texture ||
+            spriteA->x != spriteB->x || spriteA->y != spriteB->y ||
+            spriteA->sourceX != spriteB->sourceX || spriteA->sourceY != spriteB->sourceY ||
+            spriteA->sourceWidth != spriteB->sourceWidth || spriteA->sourceHeight != spriteB->sourceHeight)
+            return false;
+    }
+    return true;
+}
+// ----------------------------------------------------------------------------------